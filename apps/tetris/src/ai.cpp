@@ -0,0 +1,142 @@
+#include <cstdio>
+#include "ai.h"
+#include "trace.h"
+
+// a placement that ends the game
+static const double LOST = -1e9;
+// distinct rotations times the columns each can land in
+static const int MAX_PLACEMENTS = 4 * BOARD_WIDTH;
+
+Ai::Ai(const AiWeights &weights, ThreadPool *pool, TranspositionTable *table)
+    : weights(weights), pool(pool), table(table),
+      stats(pool ? pool->size() + 1 : 1) {}
+
+SearchStats& Ai::counters() {
+    // every pool worker has its own slot, anything else shares slot 0
+    size_t slot = pool ? ThreadPool::currentWorker() + 1 : 0;
+    return stats[slot < stats.size() ? slot : 0];
+}
+
+uint64_t Ai::nodes() const {
+    uint64_t sum = 0;
+    for (const SearchStats &s : stats) sum += s.nodes;
+    return sum;
+}
+
+bool parseAiWeights(const char *text, AiWeights &weights) {
+    AiWeights parsed;
+    if (sscanf(text, "%lf,%lf,%lf,%lf", &parsed.height, &parsed.lines,
+               &parsed.holes, &parsed.bumpiness) != 4) {
+        return false;
+    }
+    weights = parsed;
+    return true;
+}
+
+double Ai::evaluate(const Bitboard &board, int lines) const {
+    BoardFeatures features;
+    boardFeatures(&board, 1, &features);
+    return evaluate(features, lines);
+}
+
+double Ai::evaluate(const BoardFeatures &features, int lines) const {
+    // every cell under a column's surface is either filled or a hole
+    int holes = features.height - features.cells;
+    return weights.height * features.height + weights.lines * lines +
+           weights.holes * holes + weights.bumpiness * features.bumpiness;
+}
+
+double Ai::bestNext(const Bitboard &board, int type, int rotation, int lines) {
+    SearchStats &counter = counters();
+    uint64_t key = 0;
+    double best = LOST;
+    // the cached value leaves out the first ply's lines, evaluate() is
+    // linear in them
+    if (table) {
+        key = table->key(board) ^ table->pieceKey(type, rotation);
+        counter.probes += 1;
+        if (table->probe(key, best)) {
+            counter.hits += 1;
+            return best == LOST ? LOST : best + weights.lines * lines;
+        }
+    }
+
+    const Shape &spawned = shapeTable.shapes[type][rotation];
+    int top = SPAWN_ROW - HIDDEN_ROWS;
+    // block out: the next piece could not even appear
+    if (!board.collides(spawned, SPAWN_COLUMN, top)) {
+        // collect the placements, then score them in one kernel pass
+        Bitboard boards[MAX_PLACEMENTS];
+        int cleared[MAX_PLACEMENTS];
+        size_t count = 0;
+        forEachPlacement(board, type, rotation, SPAWN_COLUMN, top,
+            [&](int, int, const Bitboard &after, int more) {
+                counter.nodes += 1;
+                if (more < 0) return;
+                boards[count] = after;
+                cleared[count++] = more;
+            });
+        BoardFeatures features[MAX_PLACEMENTS];
+        boardFeatures(boards, count, features);
+        for (size_t i = 0; i < count; ++i) {
+            double score = evaluate(features[i], cleared[i]);
+            if (score > best) best = score;
+        }
+    }
+    if (table) table->store(key, best);
+    return best == LOST ? LOST : best + weights.lines * lines;
+}
+
+Placement Ai::search(const Game &game) {
+    TRACE_SCOPE("aiSearch");
+    const Tetromino &piece = game.current();
+    const Tetromino &next = game.upcoming();
+    SearchStats &counter = counters();
+    candidates.clear();
+    forEachPlacement(game.field(), piece.getType(), piece.getRotation(),
+                     piece.left(), piece.top(),
+        [&](int rotations, int left, const Bitboard &after, int lines) {
+            counter.nodes += 1;
+            Candidate candidate = {rotations, left, lines, LOST, after};
+            candidates.push_back(candidate);
+        });
+
+    auto score = [&](int i) {
+        TRACE_SCOPE("bestNext");
+        Candidate &c = candidates[i];
+        if (c.lines >= 0) c.score = bestNext(c.board, next.getType(), next.getRotation(), c.lines);
+    };
+    int count = static_cast<int>(candidates.size());
+    if (pool) {
+        pool->parallelFor(count, score);
+    } else {
+        for (int i = 0; i < count; ++i) score(i);
+    }
+
+    // first best in enumeration order, whatever thread scored it
+    Placement best = {0, piece.left(), LOST, false};
+    for (const Candidate &c : candidates) {
+        if (!best.valid || c.score > best.score) {
+            best.rotations = c.rotations;
+            best.left = c.left;
+            best.score = c.score;
+            best.valid = true;
+        }
+    }
+    return best;
+}
+
+Placement Ai::steer(Game &game) {
+    Placement target = search(game);
+    if (target.valid) {
+        for (int i = 0; i < target.rotations; ++i) game.step(Action::Rotate);
+        while (game.current().left() < target.left && game.step(Action::Right)) {}
+        while (game.current().left() > target.left && game.step(Action::Left)) {}
+    }
+    return target;
+}
+
+void Ai::play(Game &game) {
+    steer(game);
+    game.step(Action::HardDrop);
+}
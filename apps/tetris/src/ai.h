@@ -0,0 +1,124 @@
+#ifndef AI_H
+#define AI_H
+
+#include <cstdint>
+#include <vector>
+#include "bitboard.h"
+#include "game.h"
+#include "rowkernels.h"
+#include "threadpool.h"
+#include "transposition.h"
+
+// Linear evaluation of a board after a placement, see evaluate()
+struct AiWeights
+{
+    double height = -0.510066;    // sum of column heights
+    double lines = 0.760666;      // rows cleared by the placements
+    double holes = -0.35663;      // empty cells below a column's surface
+    double bumpiness = -0.184483; // sum of height steps between columns
+};
+
+// parse "height,lines,holes,bumpiness"
+bool parseAiWeights(const char*, AiWeights&);
+
+// Where to put the current piece: rotate, shift to a column, hard drop
+struct Placement
+{
+    int rotations;
+    int left;
+    double score;
+    bool valid;
+};
+
+// Per-thread search counters, padded to a cache line
+struct SearchStats
+{
+    uint64_t nodes = 0;   // boards evaluated
+    uint64_t probes = 0;  // transposition table lookups
+    uint64_t hits = 0;
+    char pad[64 - 3 * sizeof(uint64_t)];
+};
+
+// Placement search over bitboards. Every (rotation, column) the current
+// piece can reach by rotating in place, sliding sideways and hard dropping
+// is scored by the best reachable placement of the next piece on the
+// resulting board.
+//
+// With a pool, the first-ply placements are scored in parallel; with a
+// table, second-ply results are cached by board and piece. Neither changes
+// which placement is chosen.
+class Ai
+{
+public:
+    explicit Ai(const AiWeights &weights = AiWeights(), ThreadPool *pool = nullptr,
+                TranspositionTable *table = nullptr);
+    Placement search(const Game&);
+    // search and rotate and shift the current piece into the best
+    // placement through Game::step, short of dropping it
+    Placement steer(Game&);
+    // steer() and hard drop
+    void play(Game&);
+    // total number of boards evaluated
+    uint64_t nodes() const;
+    // counters of the calling thread (0) and of every pool worker (1..)
+    int threads() const { return static_cast<int>(stats.size()); }
+    const SearchStats& threadStats(int i) const { return stats[i]; }
+
+    double evaluate(const Bitboard&, int) const;
+    double evaluate(const BoardFeatures&, int) const;
+    // call f(rotations, left, board, lines) for every reachable placement
+    template <typename F>
+    static void forEachPlacement(const Bitboard&, int, int, int, int, F);
+    // best evaluation over all placements of a piece spawned on board
+    double bestNext(const Bitboard&, int, int, int);
+
+private:
+    struct Candidate
+    {
+        int rotations;
+        int left;
+        int lines;
+        double score;
+        Bitboard board;
+    };
+
+    SearchStats& counters();
+
+    AiWeights weights;
+    ThreadPool *pool;
+    TranspositionTable *table;
+    std::vector<SearchStats> stats;
+    std::vector<Candidate> candidates;
+};
+
+template <typename F>
+void Ai::forEachPlacement(const Bitboard &board, int type, int rotation,
+                          int left, int top, F f) {
+    const Shape *reached[4];
+    for (int k = 0; k < 4; ++k) {
+        const Shape &shape = shapeTable.shapes[type][(rotation + k) % 4];
+        // rotating in place stops at the first rotation that does not fit
+        if (!board.fits(shape, left, top)) break;
+        reached[k] = &shape;
+        // O, and I/S/Z half turns, repeat a shape already searched
+        bool repeated = false;
+        for (int m = 0; m < k && !repeated; ++m) {
+            repeated = memcmp(reached[m]->rows, shape.rows, sizeof(shape.rows)) == 0;
+        }
+        if (repeated) continue;
+
+        int minLeft = left, maxLeft = left;
+        while (board.fits(shape, minLeft - 1, top)) --minLeft;
+        while (board.fits(shape, maxLeft + 1, top)) ++maxLeft;
+        for (int x = minLeft; x <= maxLeft; ++x) {
+            int landed = top + board.dropDistance(shape, x, top);
+            Bitboard next = board;
+            bool visible = next.place(shape, x, landed);
+            int lines = next.removeRows(next.fullRows(landed + shape.minRow, landed + shape.maxRow),
+                                        landed + shape.minRow, landed + shape.maxRow);
+            f(k, x, next, visible ? lines : -1);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,249 @@
+// tetris-bench: plays many independent headless games across all cores
+// and reports aggregate throughput and per-thread utilization.
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <unistd.h>
+#include "ai.h"
+#include "dataset.h"
+#include "game.h"
+#include "threadpool.h"
+
+// per-thread counters, padded to a cache line to avoid false sharing
+struct ThreadTotals
+{
+    unsigned long long games = 0;
+    unsigned long long pieces = 0;
+    unsigned long long lines = 0;
+    char pad[64 - 3 * sizeof(unsigned long long)];
+};
+
+static long long monotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// random but plausible play: rotate and shift each piece, then let it fall
+template <int W, int H>
+static void playGame(BasicGame<W, H> &game, unsigned int seed, int maxPieces) {
+    std::mt19937 policy(seed ^ 0x9e3779b9u);
+    while (!game.isOver() && game.getPieces() < maxPieces) {
+        int placed = game.getPieces();
+        int rotations = policy() % 4;
+        int shift = static_cast<int>(policy() % W) - W / 2;
+        for (int i = 0; i < rotations; ++i) game.step(Action::Rotate);
+        Action side = shift < 0 ? Action::Left : Action::Right;
+        for (int i = 0; i < abs(shift); ++i) game.step(side);
+        while (!game.isOver() && game.getPieces() == placed) {
+            while (game.step(Action::Down)) {}
+            game.tick();
+        }
+    }
+}
+
+struct GameResult
+{
+    int pieces;
+    int lines;
+};
+
+typedef GameResult (*RandomGame)(unsigned int, RandomizerKind, int);
+
+template <int W, int H>
+static GameResult playRandom(unsigned int seed, RandomizerKind kind, int maxPieces) {
+    BasicGame<W, H> game(seed, kind);
+    playGame(game, seed, maxPieces);
+    GameResult result = {game.getPieces(), game.getLines()};
+    return result;
+}
+
+// the random policy for one of TETRIS_BOARD_SIZES, nullptr for other sizes
+static RandomGame randomGameFor(int width, int height) {
+#define MATCH_SIZE(W, H) if (width == W && height == H) return playRandom<W, H>;
+    TETRIS_BOARD_SIZES(MATCH_SIZE)
+#undef MATCH_SIZE
+    return nullptr;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [-n games] [-j threads] [-s seed] [-p max pieces] [-b]\n"
+                    "       [-B WIDTHxHEIGHT] [-a [-f] [-c table bits] [-o dataset prefix]]\n", argv0);
+#define LIST_SIZE(W, H) " " #W "x" #H
+    fprintf(stderr, "board sizes:" TETRIS_BOARD_SIZES(LIST_SIZE) "\n");
+#undef LIST_SIZE
+}
+
+int main(int argc, char **argv) {
+    int games = 10000;
+    int threads = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+    unsigned int seed = 1;
+    int maxPieces = 100000;
+    bool useAi = false;
+    RandomizerKind kind = RandomizerKind::Uniform;
+    bool fanOut = false;
+    int tableBits = 18;
+    int width = BOARD_WIDTH;
+    int height = BOARD_HEIGHT;
+    const char *datasetPrefix = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:j:s:p:bB:afc:o:h")) != -1) {
+        switch (opt) {
+            case 'n': games = atoi(optarg); break;
+            case 'j': threads = atoi(optarg); break;
+            case 's': seed = strtoul(optarg, NULL, 0); break;
+            case 'p': maxPieces = atoi(optarg); break;
+            case 'b': kind = RandomizerKind::Bag; break;
+            case 'B':
+                if (sscanf(optarg, "%dx%d", &width, &height) != 2) {
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'a': useAi = true; break;
+            case 'f': fanOut = true; break;
+            case 'c': tableBits = atoi(optarg); break;
+            case 'o': datasetPrefix = optarg; break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (threads < 1) threads = 1;
+    RandomGame randomGame = randomGameFor(width, height);
+    // the placement search only knows the default board
+    bool defaultSize = width == BOARD_WIDTH && height == BOARD_HEIGHT;
+    if (tableBits < 0 || tableBits > 30 || randomGame == nullptr || (useAi && !defaultSize) ||
+        (datasetPrefix != NULL && !useAi)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // one table for every game, early boards recur across seeds
+    std::unique_ptr<TranspositionTable> table;
+    if (useAi && tableBits > 0) table.reset(new TranspositionTable(tableBits));
+    // search counters by the thread that did the work, merged per game
+    std::vector<SearchStats> search(threads + 1);
+    std::mutex searchLock;
+
+    // -o: every worker appends the placements of its games to a shard of
+    // its own, PREFIX.<worker>
+    std::vector<std::unique_ptr<DatasetWriter>> shards;
+    if (datasetPrefix != NULL) {
+        for (int i = 0; i < threads; ++i) {
+            char path[512];
+            snprintf(path, sizeof(path), "%s.%d", datasetPrefix, i);
+            shards.emplace_back(new DatasetWriter());
+            if (!shards.back()->open(path)) {
+                perror(path);
+                return 1;
+            }
+        }
+    }
+
+    std::vector<ThreadTotals> totals(threads);
+    long long start = monotonicNs();
+    {
+        ThreadPool pool(threads);
+        for (int i = 0; i < games; ++i) {
+            unsigned int gameSeed = seed + i;
+            pool.submit([&, gameSeed] {
+                GameResult result;
+                if (useAi) {
+                    Game game(gameSeed, kind);
+                    // -f: also split each search's first ply across the pool
+                    Ai ai(AiWeights(), fanOut ? &pool : nullptr, table.get());
+                    if (shards.empty()) {
+                        while (!game.isOver() && game.getPieces() < maxPieces) ai.play(game);
+                    } else {
+                        DatasetWriter &shard = *shards[ThreadPool::currentWorker()];
+                        PlacementTracker tracker(gameSeed);
+                        DatasetRecord record;
+                        while (!game.isOver() && game.getPieces() < maxPieces) {
+                            tracker.before(game);
+                            ai.steer(game);
+                            tracker.before(game);
+                            game.step(Action::HardDrop);
+                            if (tracker.after(game, record)) shard.append(record);
+                        }
+                    }
+                    std::lock_guard<std::mutex> guard(searchLock);
+                    for (int k = 0; k < ai.threads(); ++k) {
+                        // without a pool every count belongs to this thread
+                        SearchStats &into = search[fanOut ? k : ThreadPool::currentWorker() + 1];
+                        into.nodes += ai.threadStats(k).nodes;
+                        into.probes += ai.threadStats(k).probes;
+                        into.hits += ai.threadStats(k).hits;
+                    }
+                    result.pieces = game.getPieces();
+                    result.lines = game.getLines();
+                } else {
+                    result = randomGame(gameSeed, kind, maxPieces);
+                }
+                ThreadTotals &t = totals[ThreadPool::currentWorker()];
+                t.games += 1;
+                t.pieces += result.pieces;
+                t.lines += result.lines;
+            });
+        }
+        pool.wait();
+        long long wall = monotonicNs() - start;
+        double seconds = wall / 1e9;
+
+        ThreadTotals sum;
+        SearchStats searched;
+        printf("thread  games     pieces      lines  tasks  steals  busy%%");
+        printf(useAi ? "       nodes   hit%%\n" : "\n");
+        for (int i = 0; i < threads; ++i) {
+            ThreadPool::WorkerStats s = pool.stats(i);
+            printf("%6d %6llu %10llu %10llu %6llu %7llu %6.1f", i,
+                   totals[i].games, totals[i].pieces, totals[i].lines,
+                   static_cast<unsigned long long>(s.tasks),
+                   static_cast<unsigned long long>(s.steals),
+                   100.0 * s.busyNs / wall);
+            const SearchStats &n = search[i + 1];
+            if (useAi) {
+                printf(" %11llu %6.1f\n", static_cast<unsigned long long>(n.nodes),
+                       n.probes ? 100.0 * n.hits / n.probes : 0.0);
+            } else {
+                printf("\n");
+            }
+            sum.games += totals[i].games;
+            sum.pieces += totals[i].pieces;
+            sum.lines += totals[i].lines;
+            searched.nodes += n.nodes;
+            searched.probes += n.probes;
+            searched.hits += n.hits;
+        }
+        printf("games: %llu  board: %dx%d  threads: %d  wall: %.3fs\n",
+               sum.games, width, height, threads, seconds);
+        printf("pieces/sec: %.0f  lines/sec: %.0f\n",
+               sum.pieces / seconds, sum.lines / seconds);
+        if (useAi) {
+            printf("nodes/sec: %.0f  table hits: %llu/%llu (%.1f%%)\n",
+                   searched.nodes / seconds,
+                   static_cast<unsigned long long>(searched.hits),
+                   static_cast<unsigned long long>(searched.probes),
+                   searched.probes ? 100.0 * searched.hits / searched.probes : 0.0);
+        }
+    }
+    if (!shards.empty()) {
+        // the last partial blocks go out here, after the timing
+        unsigned long long records = 0, bytes = 0;
+        bool ok = true;
+        for (size_t i = 0; i < shards.size(); ++i) {
+            ok = shards[i]->close() && ok;
+            records += shards[i]->records();
+            bytes += shards[i]->bytes();
+        }
+        printf("dataset: %llu records  %.1f MB in %zu shards\n",
+               records, bytes / 1e6, shards.size());
+        if (!ok) {
+            fprintf(stderr, "%s: write failed\n", datasetPrefix);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include "bitboard.h"
+
+template <int W, int H>
+void BasicBitboard<W, H>::clear() {
+    memset(rows, 0, sizeof(rows));
+    memset(heights, 0, sizeof(heights));
+}
+
+template <int W, int H>
+bool BasicBitboard<W, H>::collides(const Shape &shape, int left, int top) const {
+    for (int i = shape.minRow; i <= shape.maxRow; ++i) {
+        int row = top + i;
+        if (row < 0 || row >= H) continue;
+        if (rows[row] & shiftMask<Mask>(shape.rows[i], left)) return true;
+    }
+    return false;
+}
+
+template <int W, int H>
+bool BasicBitboard<W, H>::fits(const Shape &shape, int left, int top) const {
+    if (left + shape.minCol < 0 || left + shape.maxCol >= W) return false;
+    if (top + shape.minRow < -HIDDEN_ROWS || top + shape.maxRow >= H) return false;
+    return !collides(shape, left, top);
+}
+
+template <int W, int H>
+int BasicBitboard<W, H>::dropDistance(const Shape &shape, int left, int top) const {
+    // compare each column's lowest block with that column's surface
+    int distance = H + HIDDEN_ROWS;
+    for (int c = shape.minCol; c <= shape.maxCol; ++c) {
+        if (shape.bottom[c] < 0) continue;
+        int surface = H - heights[left + c];
+        int gap = surface - 1 - (top + shape.bottom[c]);
+        if (gap < distance) distance = gap;
+    }
+    if (distance >= 0) return distance;
+
+    // the piece was slid under an overhang, the surface is above it: probe
+    distance = 0;
+    while (top + distance + 1 + shape.maxRow < H &&
+           !collides(shape, left, top + distance + 1)) {
+        ++distance;
+    }
+    return distance;
+}
+
+template <int W, int H>
+bool BasicBitboard<W, H>::place(const Shape &shape, int left, int top) {
+    bool visible = true;
+    for (int i = shape.minRow; i <= shape.maxRow; ++i) {
+        int row = top + i;
+        Mask mask = shiftMask<Mask>(shape.rows[i], left);
+        // lock out: a block came to rest above the visible playfield
+        if (row < 0) {
+            visible = false;
+            continue;
+        }
+        rows[row] |= mask;
+        for (int j = 0; mask != 0; ++j, mask >>= 1) {
+            if ((mask & 1) && heights[j] < H - row) heights[j] = H - row;
+        }
+    }
+    return visible;
+}
+
+template <int W, int H>
+uint32_t BasicBitboard<W, H>::fullRows(int first, int last) const {
+    if (first < 0) first = 0;
+    uint32_t full = 0;
+    for (int i = first; i <= last; ++i) {
+        if (rows[i] == RowTraits<W>::full()) full |= 1u << (i - first);
+    }
+    return full;
+}
+
+template <int W, int H>
+int BasicBitboard<W, H>::removeRows(uint32_t full, int first, int last) {
+    if (full == 0) return 0;
+    if (first < 0) first = 0;
+    int removed = compactRows(rows, full, first, last);
+    updateHeights();
+    return removed;
+}
+
+template <int W, int H>
+void BasicBitboard<W, H>::updateHeights() {
+    // topmost block of every column: walk down until each column was seen
+    Mask seen = 0;
+    memset(heights, 0, sizeof(heights));
+    for (int i = 0; i < H && seen != RowTraits<W>::full(); ++i) {
+        Mask fresh = rows[i] & ~seen;
+        for (int j = 0; fresh != 0; ++j, fresh >>= 1) {
+            if (fresh & 1) heights[j] = H - i;
+        }
+        seen |= rows[i];
+    }
+}
+
+template <int W, int H>
+bool BasicBitboard<W, H>::valid() const {
+    BasicBitboard rebuilt = *this;
+    for (int i = 0; i < H; ++i) {
+        if (rows[i] & ~RowTraits<W>::full()) return false;
+    }
+    rebuilt.updateHeights();
+    return memcmp(rebuilt.heights, heights, sizeof(heights)) == 0;
+}
+
+#define INSTANTIATE_BITBOARD(W, H) template struct BasicBitboard<W, H>;
+TETRIS_BOARD_SIZES(INSTANTIATE_BITBOARD)
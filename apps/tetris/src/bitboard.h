@@ -0,0 +1,63 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <cstring>
+#include "board.h"
+#include "shapes.h"
+
+// Playfield occupancy: one mask per row plus each column's surface height.
+// Shapes are addressed by the playfield column and row of their 4x4 origin;
+// rows above the playfield (top < 0) are empty and never collide.
+// Instantiated for TETRIS_BOARD_SIZES in bitboard.cpp.
+template <int Width, int Height>
+struct BasicBitboard
+{
+    typedef typename RowTraits<Width>::Mask Mask;
+    static const int WIDTH = Width;
+    static const int HEIGHT = Height;
+
+    Mask rows[Height];
+    uint8_t heights[Width];
+
+    void clear();
+    // true if the shape overlaps a block (walls are not checked)
+    bool collides(const Shape&, int, int) const;
+    // true if the shape is inside the walls and floor and overlaps nothing
+    bool fits(const Shape&, int, int) const;
+    // rows the shape can fall before landing, from the height map when the
+    // shape is above the surface, by probing when it is under an overhang
+    int dropDistance(const Shape&, int, int) const;
+    // add the shape's blocks; false if some block stayed above the playfield
+    bool place(const Shape&, int, int);
+    // bit i - first is set for every completed row i in [first, last]
+    uint32_t fullRows(int, int) const;
+    // remove the rows flagged by fullRows(first, last), returns how many
+    int removeRows(uint32_t, int, int);
+    // rebuild heights from rows
+    void updateHeights();
+    // no bit outside the walls and heights that match the rows, for boards
+    // read back from a file
+    bool valid() const;
+};
+
+typedef BasicBitboard<BOARD_WIDTH, BOARD_HEIGHT> Bitboard;
+
+// Remove the rows flagged in `cleared` (bit i - first for row i, all inside
+// [first, last]) and move everything above them down in a single pass.
+// Shared by the row masks and by per-cell side arrays that must stay
+// aligned with them.
+template <typename Row>
+int compactRows(Row *rows, uint32_t cleared, int first, int last) {
+    int dst = last;
+    for (int src = last; src >= first; --src) {
+        if ((cleared >> (src - first)) & 1) continue;
+        if (dst != src) memcpy(&rows[dst], &rows[src], sizeof(Row));
+        --dst;
+    }
+    int removed = dst - first + 1;
+    memmove(&rows[removed], &rows[0], first * sizeof(Row));
+    memset(&rows[0], 0, removed * sizeof(Row));
+    return removed;
+}
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <cstdint>
+#include <type_traits>
+
+// default playfield geometry; the piece board has HIDDEN_ROWS extra rows on top
+const int BOARD_WIDTH = 10;
+const int BOARD_HEIGHT = 20;
+const int HIDDEN_ROWS = 4;
+
+// Board sizes the engine templates are instantiated for, as X(width, height).
+// The first one is the game itself, the others are stress variants for
+// tetris-bench; a new size only needs a line here.
+#define TETRIS_BOARD_SIZES(X) \
+    X(10, 20)                 \
+    X(16, 32)                 \
+    X(32, 48)                 \
+    X(64, 96)
+
+// Row bitboard of a board width: the narrowest of uint16_t, uint32_t and
+// uint64_t with one bit per column, bit j is column j
+template <int Width>
+struct RowTraits
+{
+    static_assert(Width >= 4 && Width <= 64, "board width must be 4 to 64 columns");
+    typedef typename std::conditional<Width <= 16, uint16_t,
+            typename std::conditional<Width <= 32, uint32_t, uint64_t>::type>::type Mask;
+    static constexpr Mask full() {
+        return static_cast<Mask>(static_cast<Mask>(~Mask(0)) >> (8 * sizeof(Mask) - Width));
+    }
+};
+
+typedef RowTraits<BOARD_WIDTH>::Mask RowMask;
+const RowMask FULL_ROW = RowTraits<BOARD_WIDTH>::full();
+
+// where new pieces appear, in piece-board coordinates
+const int SPAWN_ROW = 1;
+constexpr int spawnColumn(int width) { return (width - 4) / 2; }
+const int SPAWN_COLUMN = spawnColumn(BOARD_WIDTH);
+
+// move a shape row mask to playfield column x (x may be negative)
+template <typename Mask>
+inline Mask shiftMask(Mask mask, int x) {
+    return static_cast<Mask>(x >= 0 ? mask << x : mask >> -x);
+}
+
+#endif
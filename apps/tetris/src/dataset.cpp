@@ -0,0 +1,197 @@
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "dataset.h"
+
+struct DatasetColumn
+{
+    char name[16];
+    uint8_t kind;
+    uint8_t bytes;
+    uint16_t elements;
+    size_t offset;  // of the field in DatasetRecord
+};
+
+#define DATASET_COLUMN(field, kind, type, elements) \
+    {#field, kind, sizeof(type), elements, offsetof(DatasetRecord, field)}
+
+static const DatasetColumn COLUMNS[] = {
+    DATASET_COLUMN(game, 'u', uint32_t, 1),
+    DATASET_COLUMN(piece, 'u', uint32_t, 1),
+    DATASET_COLUMN(rows, 'u', RowMask, BOARD_HEIGHT),
+    DATASET_COLUMN(type, 'u', uint8_t, 1),
+    DATASET_COLUMN(rotation, 'u', uint8_t, 1),
+    DATASET_COLUMN(nextType, 'u', uint8_t, 1),
+    DATASET_COLUMN(nextRotation, 'u', uint8_t, 1),
+    DATASET_COLUMN(placedRotation, 'u', uint8_t, 1),
+    DATASET_COLUMN(placedLeft, 'i', int8_t, 1),
+    DATASET_COLUMN(placedTop, 'i', int8_t, 1),
+    DATASET_COLUMN(lines, 'u', uint8_t, 1),
+    DATASET_COLUMN(over, 'u', uint8_t, 1),
+    DATASET_COLUMN(reward, 'i', int32_t, 1),
+};
+
+static const int COLUMN_COUNT = sizeof(COLUMNS) / sizeof(COLUMNS[0]);
+static const char FILE_MAGIC[4] = {'T', 'T', 'D', 'S'};
+static const char BLOCK_MAGIC[4] = {'T', 'T', 'D', 'B'};
+static const uint8_t ZEROS[8] = {};
+
+static inline size_t columnBytes(const DatasetColumn &column) {
+    return column.bytes * column.elements;
+}
+
+// every column holds a full block; DATASET_BLOCK_RECORDS is a multiple of
+// 8, so each column starts 8-byte aligned
+static size_t columnStart(int c) {
+    size_t start = 0;
+    for (int i = 0; i < c; ++i) start += columnBytes(COLUMNS[i]) * DATASET_BLOCK_RECORDS;
+    return start;
+}
+
+static_assert(DATASET_BLOCK_RECORDS % 8 == 0, "columns must stay 8-byte aligned");
+
+bool DatasetWriter::open(const char *path) {
+    close();
+    fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    failed = false;
+    count = 0;
+    written = 0;
+    fileBytes = 0;
+    // reserved once and touched up front, so appending never faults
+    columns.assign(columnStart(COLUMN_COUNT), 0);
+
+    uint8_t header[20 + COLUMN_COUNT * 20];
+    uint8_t *p = header;
+    uint32_t version = DATASET_VERSION;
+    uint16_t width = BOARD_WIDTH, height = BOARD_HEIGHT;
+    uint32_t capacity = DATASET_BLOCK_RECORDS, columnCount = COLUMN_COUNT;
+    memcpy(p, FILE_MAGIC, 4);
+    memcpy(p + 4, &version, 4);
+    memcpy(p + 8, &width, 2);
+    memcpy(p + 10, &height, 2);
+    memcpy(p + 12, &capacity, 4);
+    memcpy(p + 16, &columnCount, 4);
+    p += 20;
+    for (int c = 0; c < COLUMN_COUNT; ++c) {
+        memcpy(p, COLUMNS[c].name, 16);
+        p[16] = COLUMNS[c].kind;
+        p[17] = COLUMNS[c].bytes;
+        memcpy(p + 18, &COLUMNS[c].elements, 2);
+        p += 20;
+    }
+    struct iovec iov = {header, sizeof(header)};
+    if (!writeAll(&iov, 1)) {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+    return true;
+}
+
+void DatasetWriter::append(const DatasetRecord &record) {
+    const uint8_t *from = reinterpret_cast<const uint8_t*>(&record);
+    uint8_t *to = columns.data();
+    for (int c = 0; c < COLUMN_COUNT; ++c) {
+        size_t bytes = columnBytes(COLUMNS[c]);
+        memcpy(to + count * bytes, from + COLUMNS[c].offset, bytes);
+        to += bytes * DATASET_BLOCK_RECORDS;
+    }
+    if (++count == DATASET_BLOCK_RECORDS) flush();
+}
+
+bool DatasetWriter::close() {
+    if (fd < 0) return true;
+    if (count > 0) flush();
+    if (::close(fd) != 0) failed = true;
+    fd = -1;
+    columns.clear();
+    columns.shrink_to_fit();
+    return !failed;
+}
+
+bool DatasetWriter::writeAll(struct iovec *iov, int iovCount) {
+    int first = 0;
+    while (first < iovCount) {
+        ssize_t n = writev(fd, &iov[first], iovCount - first);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        fileBytes += n;
+        // skip what the kernel took and retry with the remainder
+        size_t left = n;
+        while (first < iovCount && left >= iov[first].iov_len) {
+            left -= iov[first].iov_len;
+            ++first;
+        }
+        if (first < iovCount) {
+            iov[first].iov_base = static_cast<uint8_t*>(iov[first].iov_base) + left;
+            iov[first].iov_len -= left;
+        }
+    }
+    return true;
+}
+
+bool DatasetWriter::flush() {
+    uint8_t header[8];
+    uint32_t records = static_cast<uint32_t>(count);
+    memcpy(header, BLOCK_MAGIC, 4);
+    memcpy(header + 4, &records, 4);
+
+    // the block header, then each column and the padding after it
+    struct iovec iov[1 + 2 * COLUMN_COUNT];
+    int n = 0;
+    iov[n].iov_base = header;
+    iov[n++].iov_len = sizeof(header);
+    uint8_t *column = columns.data();
+    for (int c = 0; c < COLUMN_COUNT; ++c) {
+        size_t bytes = columnBytes(COLUMNS[c]) * count;
+        iov[n].iov_base = column;
+        iov[n++].iov_len = bytes;
+        if (bytes % 8 != 0) {
+            iov[n].iov_base = const_cast<uint8_t*>(ZEROS);
+            iov[n++].iov_len = 8 - bytes % 8;
+        }
+        column += columnBytes(COLUMNS[c]) * DATASET_BLOCK_RECORDS;
+    }
+    if (!failed && !writeAll(iov, n)) failed = true;
+    written += count;
+    count = 0;
+    return !failed;
+}
+
+void PlacementTracker::before(const Game &game) {
+    if (game.isOver()) return;
+    const Tetromino &piece = game.current();
+    if (!tracking) {
+        tracking = true;
+        pending.game = gameId;
+        pending.piece = static_cast<uint32_t>(game.getPieces());
+        for (int i = 0; i < BOARD_HEIGHT; ++i) pending.rows[i] = game.row(i);
+        pending.type = static_cast<uint8_t>(piece.getType());
+        pending.rotation = static_cast<uint8_t>(piece.getRotation());
+        pending.nextType = static_cast<uint8_t>(game.upcoming().getType());
+        pending.nextRotation = static_cast<uint8_t>(game.upcoming().getRotation());
+        score = game.getScore();
+        lines = game.getLines();
+    }
+    // the last pose before the action: a hard drop or a gravity tick locks
+    // the piece where the ghost is
+    pending.placedRotation = static_cast<uint8_t>(piece.getRotation());
+    pending.placedLeft = static_cast<int8_t>(piece.left());
+    pending.placedTop = static_cast<int8_t>(game.ghostTop());
+}
+
+bool PlacementTracker::after(const Game &game, DatasetRecord &record) {
+    if (!tracking || static_cast<uint32_t>(game.getPieces()) == pending.piece) return false;
+    tracking = false;
+    record = pending;
+    record.lines = static_cast<uint8_t>(game.getLines() - lines);
+    record.over = game.isOver() ? 1 : 0;
+    record.reward = game.getScore() - score;
+    return true;
+}
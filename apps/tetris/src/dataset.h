@@ -0,0 +1,91 @@
+#ifndef DATASET_H
+#define DATASET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "game.h"
+
+// One placement for offline policy training: the state the piece spawned
+// into, where it was put and what that earned
+struct DatasetRecord
+{
+    uint32_t game;                // seed of the game
+    uint32_t piece;               // index of the piece within its game
+    RowMask rows[BOARD_HEIGHT];   // settled board before the piece locked
+    uint8_t type;                 // falling piece and its spawn rotation
+    uint8_t rotation;
+    uint8_t nextType;             // first preview piece
+    uint8_t nextRotation;
+    uint8_t placedRotation;       // pose it locked in, as for Bitboard::place
+    int8_t placedLeft;
+    int8_t placedTop;
+    uint8_t lines;                // rows the placement cleared
+    uint8_t over;                 // the placement ended the game
+    int32_t reward;               // score it earned
+};
+
+// Columnar file of DatasetRecords, native byte order like replay keyframes:
+//
+//   header   "TTDS", u32 version, u16 board width, u16 height,
+//            u32 block capacity, u32 column count, then per column
+//            char name[16], u8 kind ('u' or 'i'), u8 element bytes,
+//            u16 elements per record
+//   blocks   "TTDB", u32 records, then every column's values for those
+//            records back to back, each column padded to 8 bytes
+//
+// Every block but the last holds DATASET_BLOCK_RECORDS records. Records
+// are gathered into preallocated column buffers and each full block goes
+// out in a single writev(), so appending is a few stores per field. A
+// writer belongs to one thread; several threads write one shard each.
+const uint32_t DATASET_VERSION = 1;
+const size_t DATASET_BLOCK_RECORDS = 16384;
+
+class DatasetWriter
+{
+public:
+    DatasetWriter() = default;
+    DatasetWriter(const DatasetWriter&) = delete;
+    DatasetWriter& operator=(const DatasetWriter&) = delete;
+    ~DatasetWriter() { close(); }
+
+    bool open(const char*);
+    void append(const DatasetRecord&);
+    // write the last partial block; false if any write failed
+    bool close();
+    bool isOpen() const { return fd >= 0; }
+    uint64_t records() const { return written + count; }
+    uint64_t bytes() const { return fileBytes; }
+
+private:
+    bool writeAll(struct iovec*, int);
+    bool flush();
+
+    int fd = -1;
+    bool failed = false;
+    std::vector<uint8_t> columns;
+    size_t count = 0;
+    uint64_t written = 0;
+    uint64_t fileBytes = 0;
+};
+
+// Turns the actions driving a game into DatasetRecords: call before() and
+// after() around every step() and tick(). The state is taken the first time
+// a piece is seen, the pose right before the action that locks it.
+class PlacementTracker
+{
+public:
+    explicit PlacementTracker(uint32_t game) : gameId(game) {}
+    void before(const Game&);
+    // true and the record filled in if the action locked a piece
+    bool after(const Game&, DatasetRecord&);
+
+private:
+    uint32_t gameId;
+    bool tracking = false;
+    DatasetRecord pending = {};
+    int score = 0;
+    int lines = 0;
+};
+
+#endif
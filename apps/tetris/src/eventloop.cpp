@@ -0,0 +1,100 @@
+#include <ctime>
+#include <poll.h>
+#include "eventloop.h"
+#include "stats.h"
+#include "trace.h"
+
+long long EventLoop::now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+EventLoop::~EventLoop() {
+    for (size_t i = 0; i < tasks.size(); ++i) tasks[i].handle.destroy();
+}
+
+int EventLoop::spawn(Task task) {
+    Slot slot;
+    slot.handle = task.handle;
+    task.handle = nullptr;
+    slot.deadline = 1;
+    tasks.push_back(slot);
+    return static_cast<int>(tasks.size()) - 1;
+}
+
+void EventLoop::at(int task, long long deadline) {
+    tasks[task].deadline = deadline;
+}
+
+bool EventLoop::watch(int task, int fd) {
+    if (fd >= 0 && tasks[task].fd < 0) {
+        int watched = 0;
+        for (size_t i = 0; i < tasks.size(); ++i) watched += tasks[i].fd >= 0;
+        if (watched >= MAX_WATCHED) return false;
+    }
+    tasks[task].fd = fd;
+    tasks[task].readable = false;
+    return true;
+}
+
+void EventLoop::run() {
+    stopping = false;
+    while (!stopping) {
+        // a deadline is one-shot: it is cleared before the task resumes,
+        // and its next wait() sets the next one
+        for (size_t i = 0; i < tasks.size() && !stopping; ++i) {
+            Slot &task = tasks[i];
+            if (task.handle.done()) continue;
+            long long time = now();
+            bool due = task.deadline != 0 && time >= task.deadline;
+            if (!due && !task.readable) continue;
+            if (due) task.deadline = 0;
+            task.readable = false;
+            running = static_cast<int>(i);
+            resumedAt = time;
+            task.handle.resume();
+            running = -1;
+        }
+        if (!stopping) sleep();
+    }
+}
+
+void EventLoop::sleep() {
+    long long wake = 0;
+    struct pollfd fds[MAX_WATCHED];
+    int watched[MAX_WATCHED];
+    nfds_t count = 0;
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        const Slot &task = tasks[i];
+        if (task.handle.done()) continue;
+        if (task.deadline != 0 && (wake == 0 || task.deadline < wake)) wake = task.deadline;
+        // watch() keeps the count within MAX_WATCHED
+        if (task.fd >= 0) {
+            fds[count].fd = task.fd;
+            fds[count].events = POLLIN;
+            fds[count].revents = 0;
+            watched[count++] = static_cast<int>(i);
+        }
+    }
+    struct timespec timeout = {0, 0};
+    if (wake != 0) {
+        long long remaining = wake - now();
+        if (remaining < 0) remaining = 0;
+        timeout.tv_sec = static_cast<time_t>(remaining / 1000000000LL);
+        timeout.tv_nsec = static_cast<long>(remaining % 1000000000LL);
+    }
+    // nothing scheduled and nothing watched would sleep forever
+    if (wake == 0 && count == 0) {
+        stopping = true;
+        return;
+    }
+    TRACE_ONLY(long long sleptAt = traceNow();)
+    int ready = ppoll(fds, count, wake != 0 ? &timeout : NULL, NULL);
+    TRACE_ONLY(traceEvent("sleep", sleptAt, traceNow());)
+    STATS_ONLY(sessionStats.pendingSyscalls += 1;)
+    STATS_ONLY(if (ready == 0) sessionStats.oversleepNs.add(statsNow() - wake);)
+    for (nfds_t i = 0; ready > 0 && i < count; ++i) {
+        if (fds[i].revents != 0) tasks[watched[i]].readable = true;
+    }
+}
@@ -0,0 +1,109 @@
+#ifndef EVENTLOOP_H
+#define EVENTLOOP_H
+
+#include <coroutine>
+#include <exception>
+#include <vector>
+
+// Single-threaded cooperative executor for C++20 coroutine tasks. A task
+// runs until it co_awaits wait(), and is resumed once the deadline it gave
+// passes, another task wakes it with at() or soon(), or the descriptor it
+// watches turns readable. Between passes the loop sleeps until the earliest
+// deadline in one ppoll over every watched descriptor, so nothing
+// busy-polls.
+//
+// A coroutine keeps references to its arguments, and a lambda coroutine to
+// its closure: both must outlive the loop, so lambdas are given a name in
+// the enclosing scope rather than called as temporaries.
+class EventLoop
+{
+public:
+    class Task
+    {
+    public:
+        struct promise_type
+        {
+            Task get_return_object() {
+                return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+            // a task starts in the first pass after spawn()
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            // the loop destroys finished frames
+            std::suspend_always final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+
+        Task(Task &&other) noexcept : handle(other.handle) { other.handle = nullptr; }
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+        ~Task() { if (handle) handle.destroy(); }
+
+    private:
+        explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+        std::coroutine_handle<promise_type> handle;
+        friend class EventLoop;
+    };
+
+    // co_await loop.wait(deadline): suspend the running task until deadline
+    // (0: no deadline of its own), a wake-up or its descriptor; evaluates to
+    // the time it was resumed at
+    class Wait
+    {
+    public:
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<>) const { loop.tasks[loop.running].deadline = deadline; }
+        long long await_resume() const noexcept { return loop.resumedAt; }
+
+    private:
+        Wait(EventLoop &loop, long long deadline) : loop(loop), deadline(deadline) {}
+        EventLoop &loop;
+        long long deadline;
+        friend class EventLoop;
+    };
+
+    // descriptors one ppoll waits on
+    static const int MAX_WATCHED = 8;
+
+    EventLoop() = default;
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+    ~EventLoop();
+
+    // CLOCK_MONOTONIC in nanoseconds, the clock every deadline is on
+    static long long now();
+
+    // tasks run in the order they were spawned within a pass
+    int spawn(Task);
+    Wait wait(long long deadline = 0) { return Wait(*this, deadline); }
+    // resume the task once `deadline` has passed, 0 cancels
+    void at(int, long long deadline);
+    // resume the task later in the current pass, or at the start of the next
+    void soon(int task) { at(task, 1); }
+    // resume the task whenever `fd` is readable (or hung up), -1 stops;
+    // false if MAX_WATCHED other tasks already watch a descriptor
+    bool watch(int, int fd);
+    // index of the task that is running
+    int current() const { return running; }
+    // run() returns after the current pass
+    void stop() { stopping = true; }
+    void run();
+
+private:
+    struct Slot
+    {
+        std::coroutine_handle<Task::promise_type> handle;
+        long long deadline = 0;
+        int fd = -1;
+        bool readable = false;
+    };
+
+    void sleep();
+
+    std::vector<Slot> tasks;
+    int running = -1;
+    long long resumedAt = 0;
+    bool stopping = false;
+};
+
+#endif
@@ -0,0 +1,101 @@
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include "framebuffer.h"
+#include "stats.h"
+
+void FrameBuffer::segment(int index) {
+    current = index;
+}
+
+void FrameBuffer::put(char c) {
+    // a frame never gets this large, but spill rather than drop bytes
+    if (length[current] == SEGMENT_SIZE) flush();
+    data[current][length[current]++] = c;
+}
+
+void FrameBuffer::put(const char *s) {
+    while (*s) put(*s++);
+}
+
+void FrameBuffer::putInt(int value) {
+    char digits[12];
+    int n = 0;
+    unsigned int v = value < 0 ? 0u - value : value;
+    do {
+        digits[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v != 0);
+    if (value < 0) put('-');
+    while (n > 0) put(digits[--n]);
+}
+
+void FrameBuffer::moveCursor(int row, int col) {
+    put("\033[");
+    putInt(row);
+    put(';');
+    putInt(col);
+    put('H');
+}
+
+void FrameBuffer::putCsi(int count, char final) {
+    put("\033[");
+    if (count != 1) putInt(count);
+    put(final);
+}
+
+size_t FrameBuffer::size() const {
+    size_t total = 0;
+    for (int i = 0; i < SEGMENTS; ++i) total += length[i];
+    return total;
+}
+
+size_t FrameBuffer::flush() {
+    struct iovec iov[SEGMENTS];
+    int count = 0;
+    for (int i = 0; i < SEGMENTS; ++i) {
+        if (length[i] == 0) continue;
+        iov[count].iov_base = data[i];
+        iov[count].iov_len = length[i];
+        ++count;
+    }
+
+    size_t written = 0;
+    int first = 0;
+    while (first < count) {
+        STATS_ONLY(long long start = statsNow();)
+        ssize_t n = count - first == 1
+            ? write(fd, iov[first].iov_base, iov[first].iov_len)
+            : writev(fd, &iov[first], count - first);
+        STATS_ONLY(sessionStats.writeNs.add(statsNow() - start);)
+        STATS_ONLY(sessionStats.pendingSyscalls += 1;)
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN) {
+                // stdout may be inherited non-blocking from the parent (the
+                // shell or a pty wrapper set O_NONBLOCK on the shared file
+                // description); wait until the terminal drains
+                struct pollfd pfd = {fd, POLLOUT, 0};
+                poll(&pfd, 1, -1);
+                STATS_ONLY(sessionStats.pendingSyscalls += 1;)
+                continue;
+            }
+            break;
+        }
+        written += n;
+        // skip what the kernel took and retry with the remainder
+        size_t left = n;
+        while (first < count && left >= iov[first].iov_len) {
+            left -= iov[first].iov_len;
+            ++first;
+        }
+        if (first < count) {
+            iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + left;
+            iov[first].iov_len -= left;
+        }
+    }
+
+    for (int i = 0; i < SEGMENTS; ++i) length[i] = 0;
+    return written;
+}
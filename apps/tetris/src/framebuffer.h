@@ -0,0 +1,36 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <cstddef>
+
+// Preallocated output buffer for one frame. Bytes are appended to the
+// current segment and the whole frame is submitted with a single write()
+// (one segment) or writev() (several segments) in flush().
+class FrameBuffer
+{
+public:
+    static const int SEGMENTS = 2;
+    static const size_t SEGMENT_SIZE = 8192;
+
+    explicit FrameBuffer(int out) : fd(out) {}
+
+    // select the segment subsequent bytes are appended to
+    void segment(int);
+    void put(char);
+    void put(const char*);
+    void putInt(int);
+    void moveCursor(int, int);
+    // CSI sequence with one count, left out when it is 1 (the default)
+    void putCsi(int, char);
+    size_t size() const;
+    // write every pending byte, returns the number of bytes written
+    size_t flush();
+
+private:
+    char data[SEGMENTS][SEGMENT_SIZE];
+    size_t length[SEGMENTS] = {};
+    int current = 0;
+    int fd;
+};
+
+#endif
@@ -1,44 +1,28 @@
-#include <cstdio>
 #include "game.h"
 #include "tetromino.h"
 
-void Game::render() {
-    tetromino.updateBoard();
-
-    // 清屏 + 光标回到左上角
-    printf("\033[2J\033[H");
-
-    for (int i = 0; i < 20; ++i) {
-        for (int j = 0; j < 10; ++j) {
-            int colorRendered = board[i][j] + tetromino.board[i+4][j];
-            char c = ' ';
-            switch (colorRendered) {
-                case 1: c = '#'; break;
-                case 2: c = '@'; break;
-                case 3: c = '*'; break;
-                default: c = ' '; break;
-            }
-            printf("%c%c", c, c);
-        }
-        printf("\n");
-    }
-
-    printf("\nLevel: %d\nScore: %d\n", level + 1, score);
+template <int W, int H>
+BasicGame<W, H>::BasicGame(unsigned int seed, RandomizerKind kind) {
+    randomizer = Randomizer(seed, kind);
+    int type, rotation;
+    randomizer.next(type, rotation);
+    tetromino = Piece(type, rotation);
+    preview.fill(randomizer);
+}
 
-    printf("Next:\n");
-    for (int i = 1; i < 5; ++i) {
-        for (int j = 3; j < 7; ++j) {
-            int colorRendered = nextTetromino.board[i][j];
-            char c = (colorRendered != 0) ? '#' : ' ';
-            printf("%c%c", c, c);
-        }
-        printf("\n");
+template <int W, int H>
+int BasicGame<W, H>::cellColor(int row, int col) const {
+    if ((board.rows[row] >> col) & 1) return colors[row][col];
+    int i = row - tetromino.top();
+    if (i >= 0 && i < 4 && ((tetromino.rowMask(i) >> col) & 1)) {
+        return tetromino.color();
     }
-
-    fflush(stdout);
+    return 0;
 }
 
-void Game::updateState () {
+template <int W, int H>
+void BasicGame<W, H>::tick() {
+    if (over) return;
     // check collisions with the bottom border
     bool collide = !tetromino.moveDown();
     // check collisions with other tetrominoes
@@ -48,29 +32,30 @@ void Game::updateState () {
     }
 
     // fix tetromino, update score and spawn a new tetromino
-    if (collide){
-        tetromino.updateBoard();
-        for (int i = 0; i < 20; ++i) {
-            for (int j = 0; j < 10; ++j) {
-                if (board[i][j] == 0) {
-                    board[i][j] = tetromino.board[i+4][j];
-                }
-            }
-        }
-        updateScore();
-        tetromino = nextTetromino;
-        nextTetromino = Tetromino();
-    }
+    if (collide) lockAndSpawn();
 }
 
-void Game::updateScore() {
-    int rowCleared = 0;
-    for (int i = 0; i < 20; ++i) {
-        if (isRowCompleted(i)) {
-            deleteRow(i);
-            rowCleared += 1;
-        }
-    }
+template <int W, int H>
+void BasicGame<W, H>::lockAndSpawn() {
+    // only the rows the piece came to rest in can have been completed
+    int top = tetromino.top();
+    const Shape &shape = tetromino.shape();
+    lockTetromino();
+    updateScore(top + shape.minRow, top + shape.maxRow);
+    tetromino = preview.pop(randomizer);
+    pieces += 1;
+    // block out: the new piece has no room to appear
+    if (collideWithTetrominoes()) over = true;
+}
+
+template <int W, int H>
+int BasicGame<W, H>::dropDistance() const {
+    return board.dropDistance(tetromino.shape(), tetromino.left(), tetromino.top());
+}
+
+template <int W, int H>
+void BasicGame<W, H>::updateScore(int first, int last) {
+    int rowCleared = clearRows(first, last);
 
     // Original Nintendo scoring system
     switch (rowCleared) {
@@ -92,54 +77,76 @@ void Game::updateScore() {
     if (completedRows % 10 > 9 && level < 9) level += 1;
 }
 
-bool Game::isRowCompleted(int row) {
-    for (int j = 0; j < 10; ++j) {
-        if (board[row][j] ==  0) return false;
-    }
-    completedRows += 1;
-    return true;
+template <int W, int H>
+int BasicGame<W, H>::clearRows(int first, int last) {
+    if (first < 0) first = 0;
+    uint32_t full = board.fullRows(first, last);
+    if (full == 0) return 0;
+    // the color side array gets the same compaction as the masks
+    compactRows(colors, full, first, last);
+    int cleared = board.removeRows(full, first, last);
+    completedRows += cleared;
+    return cleared;
 }
 
-void Game::deleteRow(int row) {
-    for (int i = row; i > 0; --i) {
-        for (int j = 0; j < 10; ++j) {
-           board[i][j] = board[i - 1][j];
-        }
-    }
-    for (int j = 0; j < 10; ++j) {
-        board[0][j] = 0;
+template <int W, int H>
+void BasicGame<W, H>::lockTetromino() {
+    const Shape &shape = tetromino.shape();
+    int left = tetromino.left();
+    int top = tetromino.top();
+    if (!board.place(shape, left, top)) over = true;
+    for (int n = 0; n < 4; ++n) {
+        int row = top + shape.cells[n][0];
+        if (row >= 0) colors[row][left + shape.cells[n][1]] = shape.color;
     }
 }
 
-bool Game::collideWithTetrominoes() {
-    tetromino.updateBoard();
-    for (int i = 0; i < 20; ++i) {
-        for (int j = 0; j < 10; ++j) {
-            if (board[i][j] != 0 && tetromino.board[i+4][j] != 0) {
-                return true;
-            }
-        }
-    }
-    return false;
+template <int W, int H>
+bool BasicGame<W, H>::collideWithTetrominoes() {
+    return board.collides(tetromino.shape(), tetromino.left(), tetromino.top());
 }
 
-void Game::trasformTetromino(int key) {
-    switch (key) {
-        case 'w': // 旋转
-            tetromino.rotate();
-            if (collideWithTetrominoes()) tetromino.rotate(true);
-            break;
-        case 'd': // 右移
-            tetromino.moveRight();
-            if (collideWithTetrominoes()) tetromino.moveLeft();
-            break;
-        case 'a': // 左移
-            tetromino.moveLeft();
-            if (collideWithTetrominoes()) tetromino.moveRight();
-            break;
-        case 's': // 下移
-            tetromino.moveDown();
-            if (collideWithTetrominoes()) tetromino.moveUp();
+template <int W, int H>
+bool BasicGame<W, H>::step(Action action) {
+    if (over) return false;
+    switch (action) {
+        case Action::Rotate:
+            if (!tetromino.rotate()) return false;
+            if (collideWithTetrominoes()) {
+                tetromino.rotate(true);
+                return false;
+            }
+            return true;
+        case Action::Right:
+            if (!tetromino.moveRight()) return false;
+            if (collideWithTetrominoes()) {
+                tetromino.moveLeft();
+                return false;
+            }
+            return true;
+        case Action::Left:
+            if (!tetromino.moveLeft()) return false;
+            if (collideWithTetrominoes()) {
+                tetromino.moveRight();
+                return false;
+            }
+            return true;
+        case Action::Down:
+            if (!tetromino.moveDown()) return false;
+            if (collideWithTetrominoes()) {
+                tetromino.moveUp();
+                return false;
+            }
+            return true;
+        case Action::HardDrop:
+            tetromino.shiftDown(dropDistance());
+            lockAndSpawn();
+            return true;
+        case Action::None:
             break;
     }
+    return false;
 }
+
+#define INSTANTIATE_GAME(W, H) template class BasicGame<W, H>;
+TETRIS_BOARD_SIZES(INSTANTIATE_GAME)
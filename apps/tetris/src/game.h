@@ -1,27 +1,90 @@
+#include "bitboard.h"
+#include "snapshot.h"
 #include "tetromino.h"
 
 #ifndef GAME_H
 #define GAME_H
 
-class Game
+// Player inputs understood by the engine, independent of any key binding
+enum class Action : uint8_t
 {
+    None,
+    Left,
+    Right,
+    Down,
+    Rotate,
+    HardDrop
+};
+
+// Headless game engine: rules and state only, no terminal I/O. The caller
+// drives it with step() for player actions and tick() for gravity. All of
+// its state lives in the Snapshot base, so save() and restore() are a
+// single copy. Instantiated for TETRIS_BOARD_SIZES in game.cpp; Game is the
+// default 10x20 board everything but the stress benchmarks uses.
+template <int Width, int Height>
+class BasicGame : private BasicSnapshot<Width, Height>
+{
+    typedef BasicSnapshot<Width, Height> State;
+
 public:
-    Game():tetromino(){};
-    void render();
-    void updateState();
-    void trasformTetromino(int);
-    int level = 0;
+    typedef BasicBitboard<Width, Height> Board;
+    typedef BasicTetromino<Width, Height> Piece;
+    typedef typename Board::Mask Mask;
+
+    explicit BasicGame(unsigned int seed, RandomizerKind = RandomizerKind::Uniform);
+    void save(State &to) const { to = *this; }
+    void restore(const State &from) { static_cast<State&>(*this) = from; }
+    // apply a player action, returns false if the piece could not move
+    bool step(Action);
+    // one gravity step: move down or lock, clear rows and spawn the next piece
+    void tick();
+    bool isOver() const { return over; }
+    const Board& field() const { return board; }
+    Mask row(int i) const { return board.rows[i]; }
+    // number of rows from the floor up to the topmost block of a column
+    int height(int col) const { return board.heights[col]; }
+    // rows the falling piece can still drop before it lands
+    int dropDistance() const;
+    // playfield row the ghost piece (landing position) starts at
+    int ghostTop() const { return tetromino.top() + dropDistance(); }
+    // color of a playfield cell including the falling piece, 0 if empty
+    int cellColor(int, int) const;
+    const Piece& current() const { return tetromino; }
+    // i-th piece after the falling one, i < PREVIEW_SIZE
+    const Piece& upcoming(int i = 0) const { return preview.peek(i); }
+    RandomizerKind randomizerKind() const { return randomizer.kind(); }
+    int getScore() const { return score; }
+    int getLines() const { return completedRows; }
+    int getPieces() const { return pieces; }
+    using State::level;
 
 private:
+    using State::board;
+    using State::colors;
+    using State::completedRows;
+    using State::score;
+    using State::pieces;
+    using State::over;
+    using State::tetromino;
+    using State::preview;
+    using State::randomizer;
+
     bool collideWithTetrominoes();
-    bool isRowCompleted(int);
-    void deleteRow(int);
-    void updateScore();
-    int board[20][10] = {};
-    int completedRows = 0;
-    int score = 0;
-    Tetromino tetromino;
-    Tetromino nextTetromino;
+    // remove the completed rows in [first, last], returns how many
+    int clearRows(int, int);
+    void updateScore(int, int);
+    void lockTetromino();
+    void lockAndSpawn();
+    friend struct MicroBench;
 };
 
+typedef BasicGame<BOARD_WIDTH, BOARD_HEIGHT> Game;
+
+// nanoseconds between two gravity steps: level 0 falls one row every
+// 10 x 50ms, each level takes off 50ms
+inline long long gravityInterval(int level) {
+    int frames = level < 9 ? 10 - level : 1;
+    return frames * 50 * 1000000LL;
+}
+
 #endif
@@ -0,0 +1,74 @@
+#include <cerrno>
+#include <ctime>
+#include <fcntl.h>
+#include <poll.h>
+#include <system_error>
+#include "input.h"
+#include "trace.h"
+
+static long long monotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+InputThread::~InputThread() {
+    if (reader.joinable()) {
+        char stop = 0;
+        while (write(stopPipe[1], &stop, 1) < 0 && errno == EINTR) {}
+        reader.join();
+    }
+    for (int end = 0; end < 2; ++end) {
+        if (stopPipe[end] >= 0) close(stopPipe[end]);
+        if (wakePipe[end] >= 0) close(wakePipe[end]);
+    }
+}
+
+bool InputThread::start(int input) {
+    if (pipe(stopPipe) != 0 || pipe(wakePipe) != 0) return false;
+    // a reader far ahead of the game must not block on a full pipe
+    fcntl(wakePipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(wakePipe[1], F_SETFL, O_NONBLOCK);
+    fd = input;
+    try {
+        reader = std::thread(&InputThread::run, this);
+    } catch (const std::system_error&) {
+        return false;
+    }
+    return true;
+}
+
+void InputThread::run() {
+    struct pollfd fds[2] = {{fd, POLLIN, 0}, {stopPipe[0], POLLIN, 0}};
+    KeyDecoder decoder;
+    TRACE_ONLY(traceThreadName("input");)
+    while (true) {
+        // raw mode reads never block, so wait for bytes or shutdown first
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        if (fds[1].revents != 0) return;
+        char keys[64];
+        TRACE_ONLY(long long readAt = traceNow();)
+        ssize_t n = read(fd, keys, sizeof(keys));
+        TRACE_ONLY(traceEvent("read", readAt, traceNow());)
+        if (n <= 0) return; // stdin closed, the game runs on gravity alone
+        KeyEvent event;
+        event.at = monotonicNs();
+        bool queued = false;
+        for (ssize_t i = 0; i < n; ++i) {
+            // a full ring drops the key rather than stall the reader
+            if (decoder.feed(keys[i], event)) queued |= queue.push(event);
+        }
+        // pushed before the write, so the game thread sees the keys once it
+        // wakes. EAGAIN means the pipe is full and a wake-up is pending.
+        char wake = 0;
+        while (queued && write(wakePipe[1], &wake, 1) < 0 && errno == EINTR) {}
+    }
+}
+
+void InputThread::acknowledge() {
+    char bytes[64];
+    while (read(wakePipe[0], bytes, sizeof(bytes)) > 0) {}
+}
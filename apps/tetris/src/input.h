@@ -0,0 +1,41 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <thread>
+#include <unistd.h>
+#include "keys.h"
+#include "spscring.h"
+
+// Optional reader thread: blocks on the terminal, decodes keys and queues
+// them on a wait-free ring, so a slow frame never delays reading input.
+// After queueing it writes a byte to a wake-up pipe, which the game thread
+// polls like any other descriptor before draining the ring.
+class InputThread
+{
+public:
+    InputThread() = default;
+    // stops and joins the reader
+    ~InputThread();
+    InputThread(const InputThread&) = delete;
+    InputThread& operator=(const InputThread&) = delete;
+
+    // start reading `fd`, false if the thread could not be set up
+    bool start(int = STDIN_FILENO);
+    // readable once keys are queued
+    int wakeFd() const { return wakePipe[0]; }
+    // empty the wake-up pipe; call before draining the ring with pop()
+    void acknowledge();
+    bool pop(KeyEvent &event) { return queue.pop(event); }
+
+private:
+    void run();
+
+    int fd = -1;
+    // written to on shutdown to wake the reader from poll()
+    int stopPipe[2] = {-1, -1};
+    int wakePipe[2] = {-1, -1};
+    SpscRing<KeyEvent, 256> queue;
+    std::thread reader;
+};
+
+#endif
@@ -0,0 +1,83 @@
+#include "keys.h"
+
+bool AutoRepeat::press(Action action, long long now) {
+    bool same = repeats(action) && action == held;
+    // repeat-rate spacing after DAS: the key is held and the timer takes
+    // over. Bytes drained in one burst share a timestamp and stay presses.
+    if (same && now - lastAt <= release &&
+        (holding || (now > lastAt && now - firstAt >= das))) {
+        if (!holding) {
+            holding = true;
+            nextShift = now;
+        }
+        lastAt = now;
+        return false;
+    }
+    // the terminal's first repeat comes late, DAS still counts from the
+    // original press
+    if (!same || now - lastAt > TERMINAL_REPEAT_DELAY) firstAt = now;
+    held = repeats(action) ? action : Action::None;
+    holding = false;
+    lastAt = now;
+    return true;
+}
+
+bool AutoRepeat::due(long long now, Action &action) {
+    if (!holding) return false;
+    if (now - lastAt > release) {
+        holding = false;
+        held = Action::None;
+        return false;
+    }
+    if (now < nextShift) return false;
+    nextShift += arr;
+    // after a stall, shift once and continue from now instead of bursting
+    if (nextShift < now) nextShift = now + arr;
+    action = held;
+    return true;
+}
+
+long long AutoRepeat::nextDeadline() const {
+    if (!holding) return 0;
+    long long end = lastAt + release + 1;
+    return nextShift < end ? nextShift : end;
+}
+
+bool KeyDecoder::feed(char byte, KeyEvent &event) {
+    if (state == Sequence) {
+        // parameter bytes (as in ESC [ 1 ; 5 A) until the final byte
+        if (byte >= 0x20 && byte < 0x40) return false;
+        state = Plain;
+        switch (byte) {
+            case 'A': event.action = Action::Rotate; break; // ↑
+            case 'B': event.action = Action::Down; break;   // ↓
+            case 'C': event.action = Action::Right; break;  // →
+            case 'D': event.action = Action::Left; break;   // ←
+            default: return false;
+        }
+        event.quit = false;
+        return true;
+    }
+    if (state == Escape) {
+        state = Plain;
+        if (byte == '[' || byte == 'O') {
+            state = Sequence;
+            return false;
+        }
+        // a lone ESC, the byte after it is a key of its own
+    }
+    if (byte == '\033') {
+        state = Escape;
+        return false;
+    }
+    event.quit = byte == 'q';
+    switch (byte) {
+        case 'w': event.action = Action::Rotate; break; // 旋转
+        case 'd': event.action = Action::Right; break;  // 右移
+        case 'a': event.action = Action::Left; break;   // 左移
+        case 's': event.action = Action::Down; break;   // 下移
+        case ' ': event.action = Action::HardDrop; break; // 直接落到底
+        default: event.action = Action::None; break;
+    }
+    return event.quit || event.action != Action::None;
+}
@@ -0,0 +1,67 @@
+#ifndef KEYS_H
+#define KEYS_H
+
+#include "game.h"
+
+// A decoded key press and when its bytes were read (monotonic ns)
+struct KeyEvent
+{
+    Action action = Action::None;
+    bool quit = false;
+    long long at = 0;
+};
+
+// Turns terminal bytes into key presses: w/a/s/d, space and q, plus the
+// arrow keys, which arrive as ESC [ A..D (ESC O A..D in application cursor
+// mode) and may be split across reads.
+class KeyDecoder
+{
+public:
+    // feed one byte; true once it completes a key this game uses
+    bool feed(char, KeyEvent&);
+
+private:
+    enum State : uint8_t { Plain, Escape, Sequence };
+    State state = Plain;
+};
+
+// Delayed auto shift / auto repeat rate for Left, Right and Down.
+//
+// A terminal sends no key-up events, only its own repeat stream while a key
+// is held. Once `das` has passed since the original press, two bytes of the
+// same key at most `release` apart are taken as that stream: from then on
+// the game shifts on its own every `arr` and the terminal's bytes only keep
+// the hold alive. No byte for `release` ends it. Faster taps, and terminals
+// repeating slower than `release`, simply get one step per byte.
+class AutoRepeat
+{
+public:
+    // longest delay before a terminal starts repeating a held key
+    static const long long TERMINAL_REPEAT_DELAY = 700000000LL;
+
+    AutoRepeat(long long das, long long arr, long long release = 100000000LL)
+        : das(das), arr(arr), release(release) {}
+    // a key was read at `now`; true if the action should be applied now,
+    // false if it only continues a hold
+    bool press(Action, long long now);
+    // true and the action while an auto shift is due at `now`
+    bool due(long long now, Action&);
+    // next time due() can return true or a hold can end, 0 if idle
+    long long nextDeadline() const;
+
+private:
+    static bool repeats(Action a) {
+        return a == Action::Left || a == Action::Right || a == Action::Down;
+    }
+
+    long long das;
+    long long arr;
+    long long release;
+    Action held = Action::None;
+    bool holding = false;
+    long long firstAt = 0;
+    long long lastAt = 0;
+    long long nextShift = 0;
+};
+
+#endif
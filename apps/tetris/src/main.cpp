@@ -1,78 +1,616 @@
+#include <cerrno>
 #include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <getopt.h>
+#include <memory>
 #include <unistd.h>
-#include <termios.h>
-#include <fcntl.h>
+#include "ai.h"
+#include "dataset.h"
+#include "eventloop.h"
 #include "game.h"
-#include <cstdlib>
-#include <sys/wait.h>
+#include "input.h"
+#include "renderer.h"
+#include "replay.h"
+#include "scores.h"
+#include "spectator.h"
+#include "stats.h"
+#include "term.h"
+#include "trace.h"
 
-static struct termios orig_termios;
+static const long long NS_PER_MS = 1000000LL;
+static const long long NS_PER_SEC = 1000000000LL;
 
-void disableRawMode() {
-    tcsetattr(STDIN_FILENO, TCSAFLUSH, &orig_termios);
+// true if a read() of stdin saw the end of input or a real error; a signal
+// (SIGWINCH) or nothing left to read only means waiting for the next wake-up
+static bool inputEnded(ssize_t n) {
+    return n == 0 || (n < 0 && errno != EINTR && errno != EAGAIN);
 }
 
-void enableRawMode() {
-    struct termios raw;
-    tcgetattr(STDIN_FILENO, &orig_termios);
-    atexit(disableRawMode);
-
-    raw = orig_termios;
-    raw.c_lflag &= ~(ECHO | ICANON); // 关闭回显，关闭行缓冲
-    raw.c_cc[VMIN] = 0;
-    raw.c_cc[VTIME] = 1; // 0.1秒超时
-    tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw);
+// FNV-1a over the board and counters, to diff the outcome of two runs
+static uint32_t stateHash(const Game &game) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < BOARD_HEIGHT; ++i) {
+        hash = (hash ^ game.row(i)) * 16777619u;
+    }
+    hash = (hash ^ game.getScore()) * 16777619u;
+    hash = (hash ^ game.getPieces()) * 16777619u;
+    return hash;
+}
 
-    // 设置非阻塞读取
-    int flags = fcntl(STDIN_FILENO, F_GETFL, 0);
-    fcntl(STDIN_FILENO, F_SETFL, flags | O_NONBLOCK);
+static void printBroadcast(const Broadcaster &broadcaster, long long elapsed) {
+    if (!broadcaster.isOpen()) return;
+    printf("broadcast: %llu packets (%llu keyframes), %llu bytes, %.1f bytes/packet, %.1f packets/s\n",
+           static_cast<unsigned long long>(broadcaster.packets()),
+           static_cast<unsigned long long>(broadcaster.keyframes()),
+           static_cast<unsigned long long>(broadcaster.bytes()),
+           broadcaster.packets() ? double(broadcaster.bytes()) / broadcaster.packets() : 0.0,
+           elapsed > 0 ? broadcaster.packets() * 1e9 / elapsed : 0.0);
 }
 
-void clear_screen() {
-    pid_t pid = fork();  // 创建子进程
-    if (pid == -1) {
-        // 处理fork失败（可选添加错误提示）
-        return;
-    }
-    
-    if (pid == 0) {
-        // 子进程：执行/musl/busybox clear
-        char *argv[] = {"/musl/busybox", "clear", NULL};  // 使用完整路径
-        execvp(argv[0], argv);  // 第一个参数是可执行文件路径
-        
-        // 如果execvp执行失败才会走到这里
-        _exit(1);  // 子进程退出
+// `threaded` reads the terminal on its own thread instead of inline
+static int play(unsigned int seed, RandomizerKind kind, AutoRepeat &repeat,
+                ReplayWriter &recorder, Broadcaster &broadcaster, ScoreStore &scores,
+                bool threaded) {
+    enableRawMode();
+    InputThread reader;
+    // falls back to reading inline if the thread can't be started
+    InputThread *input = threaded && reader.start() ? &reader : nullptr;
+    Game game(seed, kind);
+    Renderer renderer;
+    printf("Welcome to Tetris!\n");
+    printf("Pess any key(except q) to start...\n");
+    printf("usage: w/up(rotate), a/left, d/right, s/down, space(drop), q(quit)\n");
+    // frames bypass stdio, so nothing may stay behind in its buffer
+    fflush(stdout);
+
+    EventLoop loop;
+    KeyDecoder decoder;
+    bool quit = false;
+    long long started = EventLoop::now();
+    long long deadline = EventLoop::now() + gravityInterval(game.level);
+    // when the oldest key not yet on screen was read, and the last gravity
+    // step ran, for the stats
+    STATS_ONLY(long long inputAt = 0;)
+    STATS_ONLY(long long lastTick = statsNow();)
+
+    // tasks run in the order they are spawned, so within a pass the frame
+    // goes out after every key, auto shift and gravity step that was due
+    int keys = 0, shifts = 0, render = 0;
+    auto apply = [&](const KeyEvent &key) {
+        if (key.quit) {
+            quit = true;  // q退出
+            loop.stop();
+            return;
+        }
+        if (!repeat.press(key.action, key.at)) return;
+        recorder.action(key.action);
+        bool moved = game.step(key.action);
+        recorder.keyframe(game);
+        if (moved) {
+            loop.soon(render);
+            STATS_ONLY(if (inputAt == 0) inputAt = key.at;)
+        }
+    };
+    // a burst of keys is applied at once and shown in a single frame
+    auto keyTask = [&]() -> EventLoop::Task {
+        for (;;) {
+            co_await loop.wait();
+            TRACE_SCOPE("input");
+            KeyEvent key;
+            if (input != nullptr) {
+                input->acknowledge();
+                while (!quit && input->pop(key)) apply(key);
+            } else {
+                // drain everything the terminal has queued
+                char bytes[64];
+                STATS_ONLY(long long start = statsNow();)
+                TRACE_ONLY(long long readAt = traceNow();)
+                ssize_t n = read(STDIN_FILENO, bytes, sizeof(bytes));
+                TRACE_ONLY(traceEvent("read", readAt, traceNow());)
+                STATS_ONLY(sessionStats.pendingSyscalls += 1;)
+                STATS_ONLY(sessionStats.readNs.add(statsNow() - start);)
+                if (inputEnded(n)) loop.watch(loop.current(), -1); // keep running on gravity only
+                key.at = EventLoop::now();
+                for (ssize_t i = 0; i < n && !quit; ++i) {
+                    if (decoder.feed(bytes[i], key)) apply(key);
+                }
+            }
+            loop.at(shifts, repeat.nextDeadline());
+        }
+    };
+
+    // held keys shift on their own timer
+    auto shiftTask = [&]() -> EventLoop::Task {
+        for (;;) {
+            long long now = co_await loop.wait(repeat.nextDeadline());
+            TRACE_SCOPE("autoShift");
+            Action shift;
+            while (repeat.due(now, shift)) {
+                recorder.action(shift);
+                if (game.step(shift)) loop.soon(render);
+                recorder.keyframe(game);
+            }
+        }
+    };
+
+    // fixed timestep: run every gravity step whose deadline has passed,
+    // independently of how long rendering took
+    auto gravityTask = [&]() -> EventLoop::Task {
+        for (;;) {
+            long long now = co_await loop.wait(deadline);
+            TRACE_SCOPE("gravity");
+            if (now - deadline > NS_PER_SEC) deadline = now; // resync after a stall
+            while (now >= deadline && !game.isOver()) {
+                STATS_ONLY(long long intended = gravityInterval(game.level);)
+                game.tick();
+                recorder.tick();
+                recorder.keyframe(game);
+                deadline += gravityInterval(game.level);
+                STATS_ONLY(
+                    long long ticked = statsNow();
+                    sessionStats.gravityNs.add(ticked - lastTick);
+                    sessionStats.gravityErrorNs.add(ticked - lastTick - intended);
+                    lastTick = ticked;
+                )
+            }
+            loop.soon(render);
+        }
+    };
+
+    // draws once when spawned, then whenever another task wakes it
+    auto renderTask = [&]() -> EventLoop::Task {
+        for (;;) {
+            STATS_ONLY(long long start = statsNow();)
+            STATS_ONLY(size_t bytes =) renderer.draw(game);
+            broadcaster.send(game);
+            STATS_ONLY(
+                long long drawn = statsNow();
+                sessionStats.renderNs.add(drawn - start);
+                sessionStats.bytes.add(bytes);
+                sessionStats.syscalls.add(sessionStats.pendingSyscalls);
+                sessionStats.pendingSyscalls = 0;
+                if (inputAt != 0) sessionStats.latencyNs.add(drawn - inputAt);
+                inputAt = 0;
+            )
+            if (game.isOver()) loop.stop();
+            co_await loop.wait();
+        }
+    };
+
+    keys = loop.spawn(keyTask());
+    loop.watch(keys, input != nullptr ? input->wakeFd() : STDIN_FILENO);
+    shifts = loop.spawn(shiftTask());
+    loop.spawn(gravityTask());
+    render = loop.spawn(renderTask());
+
+#ifdef TETRIS_STATS
+    // refresh the status line once a second
+    auto overlayTask = [&]() -> EventLoop::Task {
+        for (long long now = EventLoop::now();;) {
+            now = co_await loop.wait(now + NS_PER_SEC);
+            char line[128];
+            sessionStats.overlay(line, sizeof(line));
+            renderer.drawStatus(line);
+        }
+    };
+    loop.spawn(overlayTask());
+#endif
+
+    loop.run();
+    bool recorded = recorder.close();
+    disableRawMode();
+    if (quit) {
+        printf("Exiting Tetris. Goodbye!\n");
     } else {
-        // 父进程：等待子进程完成清屏
-        waitpid(pid, NULL, 0);
+        printf("Game over! Score: %d\n", game.getScore());
+    }
+    int rank = scores.record(game.getScore(), game.getLines(), game.getPieces(), game.level);
+    if (rank > 0) printf("High score #%d!\n", rank);
+    printBroadcast(broadcaster, EventLoop::now() - started);
+    STATS_ONLY(sessionStats.print(stdout);)
+    if (!recorded) {
+        fprintf(stderr, "replay: write failed\n");
+        return 1;
+    }
+    return 0;
+}
+
+// stops `loop` when the viewer presses q
+static EventLoop::Task quitKey(EventLoop &loop) {
+    for (;;) {
+        co_await loop.wait();
+        char keys[64];
+        ssize_t n = read(STDIN_FILENO, keys, sizeof(keys));
+        if (inputEnded(n)) loop.watch(loop.current(), -1);
+        for (ssize_t i = 0; i < n; ++i) {
+            if (keys[i] == 'q') loop.stop();
+        }
     }
 }
 
-int main() {
+static void addQuitKey(EventLoop &loop) {
+    loop.watch(loop.spawn(quitKey(loop)), STDIN_FILENO);
+}
+
+// Where --seek or --seek-ticks starts (or stops) a replay
+struct ReplayTarget
+{
+    int piece = 0;
+    long long ticks = -1;
+};
+
+// bring a fresh game to the target, false after reporting why it can't
+static bool seekReplay(ReplayReader &reader, const ReplayTarget &target, Game &game) {
+    if (target.ticks >= 0) {
+        uint32_t ticks = target.ticks < UINT32_MAX ? static_cast<uint32_t>(target.ticks) : UINT32_MAX;
+        if (reader.seekTicks(ticks, game)) return true;
+        fprintf(stderr, "the replay ends before gravity step %lld\n", target.ticks);
+        return false;
+    }
+    if (target.piece <= 0 || reader.seek(target.piece, game)) return true;
+    fprintf(stderr, "the replay ends before piece %d\n", target.piece);
+    return false;
+}
+
+// play a recording back at the speed it was recorded
+static int watch(ReplayReader &reader, const ReplayTarget &target) {
+    Game game(reader.seed(), reader.randomizer());
+    if (!seekReplay(reader, target, game)) return 1;
     enableRawMode();
-    Game game;
-    clear_screen();
-    printf("Welcome to Tetris!\n");
-    printf("Pess any key(except q) to start...\n");
-    printf("usage: w(rotate), a(left), d(right), s(down), q(quit)\n");
-    while (true) {
-        // 根据 level 控制游戏速度，这里简化为固定时间循环
-        for (int i = 0; game.level < 10 && i < 10 - game.level; ++i) {
-            char input = 0;
-            ssize_t nread = read(STDIN_FILENO, &input, 1);
-            if (nread == 1) {
-                if (input == 'q') {
-                    clear_screen();
-                    printf("Exiting Tetris. Goodbye!\n");
-                    return 0;  // q退出
-                }    
-                game.trasformTetromino(input);
+    Renderer renderer;
+    renderer.draw(game);
+
+    EventLoop loop;
+    addQuitKey(loop);
+    long long deadline = EventLoop::now() + gravityInterval(game.level);
+    // every gravity step waits for its deadline, the actions between two
+    // steps are shown as soon as the step before them
+    auto replayTask = [&]() -> EventLoop::Task {
+        ReplayEvent event;
+        while (reader.next(event)) {
+            for (uint32_t i = 0; i < event.ticks; ++i) {
+                co_await loop.wait(deadline);
+                TRACE_SCOPE("replay");
+                game.tick();
+                deadline += gravityInterval(game.level);
+                renderer.draw(game);
             }
-            game.render();
-            usleep(50000); // 50ms 小延迟
+            if (event.end) break;
+            game.step(event.action);
+            renderer.draw(game);
         }
-        game.updateState();
+        loop.stop();
+    };
+    loop.spawn(replayTask());
+    loop.run();
+
+    disableRawMode();
+    printf("Replay finished. Score: %d\n", game.getScore());
+    return 0;
+}
+
+// let the placement search play, one piece every delayMs milliseconds
+static int autoplay(unsigned int seed, RandomizerKind kind, const AiWeights &weights,
+                    int delayMs, int threads, Broadcaster &broadcaster) {
+    // the calling thread searches too, so the pool gets one worker less
+    std::unique_ptr<ThreadPool> pool;
+    if (threads > 1) pool.reset(new ThreadPool(threads - 1));
+    TranspositionTable table;
+    enableRawMode();
+    Game game(seed, kind);
+    Renderer renderer;
+    Ai ai(weights, pool.get(), &table);
+    renderer.draw(game);
+
+    EventLoop loop;
+    addQuitKey(loop);
+    long long searchNs = 0;
+    long long started = EventLoop::now();
+    long long next = started;
+    auto searchTask = [&]() -> EventLoop::Task {
+        while (!game.isOver()) {
+            // the quit key is still read between two pieces at delay 0
+            long long now = co_await loop.wait(next);
+            ai.play(game);
+            searchNs += EventLoop::now() - now;
+            renderer.draw(game);
+            broadcaster.send(game);
+            next += delayMs * NS_PER_MS;
+        }
+        loop.stop();
+    };
+    loop.spawn(searchTask());
+    loop.run();
+
+    disableRawMode();
+    printf("pieces: %d  lines: %d  score: %d\n",
+           game.getPieces(), game.getLines(), game.getScore());
+    printf("boards evaluated: %llu  (%.0f/s)\n",
+           static_cast<unsigned long long>(ai.nodes()),
+           searchNs > 0 ? ai.nodes() * 1e9 / searchNs : 0.0);
+    for (int i = 0; i < ai.threads(); ++i) {
+        const SearchStats &s = ai.threadStats(i);
+        printf("  thread %d: %llu nodes, table hits %llu/%llu (%.1f%%)\n", i,
+               static_cast<unsigned long long>(s.nodes),
+               static_cast<unsigned long long>(s.hits),
+               static_cast<unsigned long long>(s.probes),
+               s.probes ? 100.0 * s.hits / s.probes : 0.0);
+    }
+    printBroadcast(broadcaster, EventLoop::now() - started);
+    return 0;
+}
+
+// render the game broadcast to `port` until q
+static int spectate(int port) {
+    Spectator spectator;
+    if (!spectator.open(port)) {
+        perror("spectate");
+        return 1;
+    }
+    enableRawMode();
+    Renderer renderer;
+    renderer.drawStatus("waiting for a keyframe...");
+
+    EventLoop loop;
+    addQuitKey(loop);
+    long long started = EventLoop::now();
+    auto receiveTask = [&]() -> EventLoop::Task {
+        for (;;) {
+            co_await loop.wait();
+            TRACE_SCOPE("receive");
+            if (!spectator.receive()) continue;
+            Frame frame;
+            spectatorFrame(spectator.state(), frame);
+            renderer.draw(frame);
+        }
+    };
+    loop.watch(loop.spawn(receiveTask()), spectator.socketFd());
+    loop.run();
+
+    long long elapsed = EventLoop::now() - started;
+    disableRawMode();
+    const SpectatorState &state = spectator.state();
+    printf("last seen: score %u  lines %u  pieces %u%s\n", state.score, state.lines,
+           state.pieces, state.over ? "  (game over)" : "");
+    printf("received: %llu packets, %llu bytes, %llu lost, %.1f packets/s\n",
+           static_cast<unsigned long long>(spectator.packets()),
+           static_cast<unsigned long long>(spectator.bytes()),
+           static_cast<unsigned long long>(spectator.lost()),
+           elapsed > 0 ? spectator.packets() * 1e9 / elapsed : 0.0);
+    return 0;
+}
+
+// replay headless as fast as the CPU allows and print the final state
+// with a target, print the state at that moment instead
+static int fastForwardReplay(ReplayReader &reader, const ReplayTarget &target) {
+    Game game(reader.seed(), reader.randomizer());
+    printf("seed: %u  randomizer: %s  keyframes: %zu\n", reader.seed(),
+           randomizerName(reader.randomizer()), reader.keyframeCount());
+    long long start = EventLoop::now();
+    if (target.piece > 0 || target.ticks >= 0) {
+        if (!seekReplay(reader, target, game)) return 1;
+        long long elapsed = EventLoop::now() - start;
+        if (target.ticks >= 0) {
+            printf("seek to gravity step %lld: %.3fms\n", target.ticks, elapsed / 1e6);
+        } else {
+            printf("seek to piece %d: %.3fms\n", target.piece, elapsed / 1e6);
+        }
+    } else {
+        ReplayResult result = fastForward(reader, game);
+        long long elapsed = EventLoop::now() - start;
+        printf("ticks: %llu  actions: %llu  time: %.3fms\n",
+               static_cast<unsigned long long>(result.ticks),
+               static_cast<unsigned long long>(result.actions),
+               elapsed / 1e6);
+    }
+    printf("score: %d  lines: %d  pieces: %d  level: %d  over: %s\n",
+           game.getScore(), game.getLines(), game.getPieces(), game.level + 1,
+           game.isOver() ? "yes" : "no");
+    printf("state: %08x\n", stateHash(game));
+    return 0;
+}
+
+// replay headless and write one DatasetRecord per placed piece to path
+static int exportReplay(ReplayReader &reader, const char *path) {
+    DatasetWriter writer;
+    if (!writer.open(path)) {
+        perror(path);
+        return 1;
+    }
+    Game game(reader.seed(), reader.randomizer());
+    PlacementTracker tracker(reader.seed());
+    DatasetRecord record;
+    ReplayEvent event;
+    long long start = EventLoop::now();
+    while (reader.next(event)) {
+        for (uint32_t i = 0; i < event.ticks; ++i) {
+            tracker.before(game);
+            game.tick();
+            if (tracker.after(game, record)) writer.append(record);
+        }
+        if (event.end) break;
+        tracker.before(game);
+        game.step(event.action);
+        if (tracker.after(game, record)) writer.append(record);
+    }
+    uint64_t records = writer.records();
+    if (!writer.close()) {
+        perror(path);
+        return 1;
     }
+    printf("exported %llu records, %llu bytes in %.3fms\n",
+           static_cast<unsigned long long>(records),
+           static_cast<unsigned long long>(writer.bytes()),
+           (EventLoop::now() - start) / 1e6);
+    return 0;
+}
 
+static int printScores(const char *path) {
+    ScoreStore scores;
+    if (!scores.open(path)) {
+        perror(path);
+        return 1;
+    }
+    const ScoreTotals &totals = scores.totals();
+    printf("sessions: %llu  pieces: %llu  lines: %llu\n",
+           static_cast<unsigned long long>(totals.sessions),
+           static_cast<unsigned long long>(totals.pieces),
+           static_cast<unsigned long long>(totals.lines));
+    for (int i = 0; i < scores.tableSize(); ++i) {
+        const ScoreRecord &entry = scores.table(i);
+        char date[32];
+        time_t endedAt = static_cast<time_t>(entry.endedAt);
+        strftime(date, sizeof(date), "%Y-%m-%d %H:%M", localtime(&endedAt));
+        printf("%2d. %8u  lines %5u  pieces %6u  level %2u  %s\n", i + 1, entry.score,
+               entry.lines, entry.pieces, entry.level + 1, date);
+    }
     return 0;
 }
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s [--seed N] [--randomizer uniform|bag] [--record FILE]\n"
+            "          [--das MS] [--arr MS] [--input-thread] [--broadcast HOST:PORT]\n"
+            "          [--scores FILE]\n"
+            "       %s --ai [--seed N] [--ai-delay MS] [--ai-weights H,L,O,B]\n"
+            "            [--ai-threads N] [--broadcast HOST:PORT]\n"
+            "       %s --replay FILE [--fast] [--seek PIECE | --seek-ticks N] [--export FILE]\n"
+            "       %s --spectate PORT\n"
+            "       %s --high-scores [--scores FILE]\n"
+            "any mode: [--trace FILE] (TRACE=1 builds)\n", argv0, argv0, argv0, argv0, argv0);
+}
+
+int main(int argc, char **argv) {
+    static const struct option options[] = {
+        {"seed", required_argument, NULL, 's'},
+        {"randomizer", required_argument, NULL, 'R'},
+        {"das", required_argument, NULL, 'D'},
+        {"arr", required_argument, NULL, 'A'},
+        {"input-thread", no_argument, NULL, 'i'},
+        {"record", required_argument, NULL, 'r'},
+        {"replay", required_argument, NULL, 'p'},
+        {"fast", no_argument, NULL, 'f'},
+        {"seek", required_argument, NULL, 'S'},
+        {"seek-ticks", required_argument, NULL, 'K'},
+        {"export", required_argument, NULL, 'x'},
+        {"ai", no_argument, NULL, 'a'},
+        {"ai-delay", required_argument, NULL, 'd'},
+        {"ai-threads", required_argument, NULL, 't'},
+        {"ai-weights", required_argument, NULL, 'w'},
+        {"broadcast", required_argument, NULL, 'b'},
+        {"spectate", required_argument, NULL, 'v'},
+        {"scores", required_argument, NULL, 'o'},
+        {"high-scores", no_argument, NULL, 'H'},
+        {"trace", required_argument, NULL, 'T'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+    unsigned int seed = static_cast<unsigned int>(time(nullptr));
+    RandomizerKind kind = RandomizerKind::Uniform;
+    // delayed auto shift and auto repeat rate of held keys
+    int das = 167;
+    int arr = 33;
+    bool inputThread = false;
+    const char *recordPath = NULL;
+    const char *replayPath = NULL;
+    bool fast = false;
+    ReplayTarget seekTo;
+    const char *exportPath = NULL;
+    bool autoplayer = false;
+    int aiDelay = 50;
+    int aiThreads = 1;
+    AiWeights weights;
+    const char *broadcastTo = NULL;
+    int spectatePort = 0;
+    const char *scorePath = defaultScorePath();
+    bool highScores = false;
+    const char *tracePath = NULL;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "s:R:D:A:ir:p:fS:K:x:ad:t:w:b:v:o:HT:h", options, NULL)) != -1) {
+        switch (opt) {
+            case 's': seed = strtoul(optarg, NULL, 0); break;
+            case 'R':
+                if (!parseRandomizer(optarg, kind)) {
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'D': das = atoi(optarg); break;
+            case 'A': arr = atoi(optarg); break;
+            case 'i': inputThread = true; break;
+            case 'r': recordPath = optarg; break;
+            case 'p': replayPath = optarg; break;
+            case 'f': fast = true; break;
+            case 'S': seekTo.piece = atoi(optarg); break;
+            case 'K': seekTo.ticks = strtoll(optarg, NULL, 0); break;
+            case 'x': exportPath = optarg; break;
+            case 'a': autoplayer = true; break;
+            case 'd': aiDelay = atoi(optarg); break;
+            case 't': aiThreads = atoi(optarg); break;
+            case 'w':
+                if (!parseAiWeights(optarg, weights)) {
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'b': broadcastTo = optarg; break;
+            case 'v': spectatePort = atoi(optarg); break;
+            case 'o': scorePath = optarg; break;
+            case 'H': highScores = true; break;
+            case 'T': tracePath = optarg; break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+
+    if (tracePath != NULL) {
+#ifdef TETRIS_TRACE
+        // written once main returns, after every other thread was joined
+        traceThreadName("main");
+        traceDumpAtExit(tracePath);
+#else
+        fprintf(stderr, "--trace needs a build with TRACE=1\n");
+        return 1;
+#endif
+    }
+
+    if (replayPath != NULL) {
+        ReplayReader reader;
+        if (!reader.open(replayPath)) {
+            fprintf(stderr, "%s: not a valid replay\n", replayPath);
+            return 1;
+        }
+        if (exportPath != NULL) return exportReplay(reader, exportPath);
+        return fast ? fastForwardReplay(reader, seekTo) : watch(reader, seekTo);
+    }
+
+    if (spectatePort > 0) return spectate(spectatePort);
+    if (highScores) return printScores(scorePath);
+
+    // checked before anything below creates a file
+    if (das < 0 || arr < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    Broadcaster broadcaster;
+    // the game id tells apart several senders to one port
+    uint32_t gameId = static_cast<uint32_t>(getpid()) * 2654435761u ^ seed;
+    if (broadcastTo != NULL && !broadcaster.open(broadcastTo, gameId)) {
+        fprintf(stderr, "%s: expected IPV4:PORT or localhost:PORT\n", broadcastTo);
+        return 1;
+    }
+    if (autoplayer) return autoplay(seed, kind, weights, aiDelay, aiThreads, broadcaster);
+
+    ReplayWriter recorder;
+    if (recordPath != NULL && !recorder.open(recordPath, seed, kind)) {
+        perror(recordPath);
+        return 1;
+    }
+    AutoRepeat repeat(das * NS_PER_MS, arr * NS_PER_MS);
+    // a game without a score store is still a game
+    ScoreStore scores;
+    if (!scores.open(scorePath)) perror(scorePath);
+    return play(seed, kind, repeat, recorder, broadcaster, scores, inputThread);
+}
@@ -0,0 +1,328 @@
+// tetris-microbench: times the Tetromino/Game hot paths on fixed seeds and
+// board fixtures and prints one CSV line per (operation, variant, fixture).
+//
+// The "legacy" variants are the original cell-scanning implementations
+// (24x10 piece board, int board[20][10]) kept here as a fixed baseline, so
+// every run measures the current code against the same reference.
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <random>
+#include <unistd.h>
+#include <vector>
+#include "game.h"
+#include "renderer.h"
+#include "rowkernels.h"
+#include "tetrominoes.h"
+
+// raw cycle counter of the running hart/core
+static inline uint64_t readCycles() {
+#if defined(__riscv)
+    uint64_t c;
+#ifdef MICROBENCH_RDCYCLE
+    // Linux >= 6.6 traps user rdcycle (SIGILL) unless perf_user_access is set
+    asm volatile("rdcycle %0" : "=r"(c));
+#else
+    asm volatile("rdtime %0" : "=r"(c));
+#endif
+    return c;
+#elif defined(__loongarch64)
+    uint64_t c;
+    asm volatile("rdtime.d %0, $zero" : "=r"(c));
+    return c;
+#elif defined(__x86_64__) || defined(__i386__)
+    uint32_t lo, hi;
+    asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+#else
+    return 0;
+#endif
+}
+
+static inline uint64_t monotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// defeats dead-code elimination of the timed calls
+static volatile int sink;
+
+struct Options
+{
+    int warmup = 20;
+    int reps = 200;
+    int batch = 256;
+    unsigned int seed = 1;
+};
+
+enum Fixture
+{
+    EMPTY,   // empty playfield
+    STACK,   // bottom half filled, one hole per row
+    CLEAR4   // four complete rows at the bottom on top of STACK
+};
+
+static const char *fixtureNames[] = {"empty", "stack", "clear4"};
+
+// Original (pre-bitboard) representation and algorithms
+struct LegacyPiece
+{
+    int board[24][10];
+    int y, x, rotation, type;
+};
+
+struct LegacyBoard
+{
+    int cells[20][10];
+};
+
+// what a Game copy used to move around
+struct LegacyGame
+{
+    int board[20][10];
+    int level, completedRows, score;
+    std::mt19937 rng;
+    LegacyPiece tetromino, nextTetromino;
+};
+
+static void legacyUpdateBoard(LegacyPiece &p) {
+    for (int i = 0; i < 20 + 4; ++i) {
+        for (int j = 0; j < 10; ++j) {
+            if (i - p.y < 4 && i - p.y >= 0 &&
+                j - p.x < 4 && j - p.x >= 0) {
+                p.board[i][j] = tetrominoes[p.type][p.rotation][i - p.y][j - p.x];
+            } else {
+                p.board[i][j] = 0;
+            }
+        }
+    }
+}
+
+static bool legacyCollideWithBorder(LegacyPiece &p) {
+    legacyUpdateBoard(p);
+    int block = 0;
+    for (int i = 0; i < 20 + 4; ++i) {
+        for (int j = 0; j < 10; ++j) {
+            if (p.board[i][j] != 0) block += 1;
+        }
+    }
+    return block < 4;
+}
+
+static bool legacyCollideWithTetrominoes(int (&board)[20][10], LegacyPiece &p) {
+    legacyUpdateBoard(p);
+    for (int i = 0; i < 20; ++i) {
+        for (int j = 0; j < 10; ++j) {
+            if (board[i][j] != 0 && p.board[i+4][j] != 0) return true;
+        }
+    }
+    return false;
+}
+
+static int legacyUpdateScore(int (&board)[20][10]) {
+    int rowCleared = 0;
+    for (int i = 0; i < 20; ++i) {
+        bool completed = true;
+        for (int j = 0; j < 10; ++j) {
+            if (board[i][j] == 0) completed = false;
+        }
+        if (!completed) continue;
+        for (int k = i; k > 0; --k) {
+            for (int j = 0; j < 10; ++j) board[k][j] = board[k - 1][j];
+        }
+        for (int j = 0; j < 10; ++j) board[0][j] = 0;
+        rowCleared += 1;
+    }
+    return rowCleared;
+}
+
+struct Result
+{
+    uint64_t medianNs, p99Ns, medianCycles, p99Cycles;
+};
+
+// times `reps` batches of `batch` calls, reports per-call cost
+template <typename Setup, typename Body>
+static Result measure(const Options &opt, Setup setup, Body body) {
+    std::vector<double> ns, cycles;
+    for (int r = 0; r < opt.warmup + opt.reps; ++r) {
+        setup();
+        uint64_t c0 = readCycles();
+        uint64_t t0 = monotonicNs();
+        for (int i = 0; i < opt.batch; ++i) body(i);
+        uint64_t t1 = monotonicNs();
+        uint64_t c1 = readCycles();
+        if (r < opt.warmup) continue;
+        ns.push_back(static_cast<double>(t1 - t0) / opt.batch);
+        cycles.push_back(static_cast<double>(c1 - c0) / opt.batch);
+    }
+    std::sort(ns.begin(), ns.end());
+    std::sort(cycles.begin(), cycles.end());
+    size_t mid = ns.size() / 2;
+    size_t p99 = std::min(ns.size() - 1, ns.size() * 99 / 100);
+    Result result = {
+        static_cast<uint64_t>(ns[mid]), static_cast<uint64_t>(ns[p99]),
+        static_cast<uint64_t>(cycles[mid]), static_cast<uint64_t>(cycles[p99])
+    };
+    return result;
+}
+
+static void report(const Options &opt, const char *op, const char *variant,
+                   Fixture fixture, const Result &r) {
+    printf("%s,%s,%s,%d,%d,%llu,%llu,%llu,%llu\n", op, variant,
+           fixtureNames[fixture], opt.reps, opt.batch,
+           static_cast<unsigned long long>(r.medianNs),
+           static_cast<unsigned long long>(r.p99Ns),
+           static_cast<unsigned long long>(r.medianCycles),
+           static_cast<unsigned long long>(r.p99Cycles));
+}
+
+struct MicroBench
+{
+    // deterministic board for a fixture, in both representations
+    static void makeFixture(Fixture fixture, unsigned int seed, Game &game,
+                            int (&legacy)[20][10]) {
+        std::mt19937 gen(seed);
+        game.board.clear();
+        memset(game.colors, 0, sizeof(game.colors));
+        memset(legacy, 0, sizeof(legacy));
+        if (fixture == EMPTY) return;
+        for (int i = BOARD_HEIGHT / 2; i < BOARD_HEIGHT; ++i) {
+            int hole = gen() % BOARD_WIDTH;
+            bool full = fixture == CLEAR4 && i >= BOARD_HEIGHT - 4;
+            for (int j = 0; j < BOARD_WIDTH; ++j) {
+                if (j == hole && !full) continue;
+                int color = 1 + gen() % 7;
+                game.board.rows[i] |= 1 << j;
+                game.colors[i][j] = color;
+                legacy[i][j] = color;
+            }
+        }
+        game.board.updateHeights();
+    }
+
+    // put the falling piece just above the fixture's surface
+    static void placePiece(Game &game, LegacyPiece &legacy, Fixture fixture) {
+        Tetromino &t = game.tetromino;
+        t.y = fixture == EMPTY ? BOARD_HEIGHT : HIDDEN_ROWS + BOARD_HEIGHT / 2 - 3;
+        t.x = 3;
+        legacy.y = t.y;
+        legacy.x = t.x;
+        legacy.type = t.type;
+        legacy.rotation = t.rotation;
+    }
+
+    static void run(const Options &opt) {
+        static const Fixture fixtures[] = {EMPTY, STACK, CLEAR4};
+        int devnull = open("/dev/null", O_WRONLY);
+        Renderer renderer(devnull);
+
+        for (Fixture fixture : fixtures) {
+            Game game(opt.seed);
+            int legacyBoard[20][10];
+            LegacyPiece legacyPiece;
+            makeFixture(fixture, opt.seed, game, legacyBoard);
+            placePiece(game, legacyPiece, fixture);
+
+            // the current piece has no board to redraw, cells come from
+            // shapeTable, so only the legacy variant is left to time
+            report(opt, "updateBoard", "legacy", fixture, measure(opt, [] {},
+                [&](int) { legacyUpdateBoard(legacyPiece); sink = legacyPiece.board[5][5]; }));
+
+            // tetromino = preview.pop() after every lock
+            std::vector<Tetromino> pieces(opt.batch, game.tetromino);
+            std::vector<LegacyPiece> legacyPieces(opt.batch, legacyPiece);
+            report(opt, "copyPiece", "current", fixture, measure(opt, [] {},
+                [&](int i) { pieces[i] = game.upcoming(); sink = pieces[i].left(); }));
+            report(opt, "copyPiece", "legacy", fixture, measure(opt, [] {},
+                [&](int i) { legacyPieces[i] = legacyPiece; sink = legacyPieces[i].x; }));
+
+            report(opt, "collideWithBorder", "current", fixture, measure(opt, [] {},
+                [&](int) { sink = game.tetromino.collideWithBorder(); }));
+            report(opt, "collideWithBorder", "legacy", fixture, measure(opt, [] {},
+                [&](int) { sink = legacyCollideWithBorder(legacyPiece); }));
+
+            report(opt, "collideWithTetrominoes", "current", fixture, measure(opt, [] {},
+                [&](int) { sink = game.collideWithTetrominoes(); }));
+            report(opt, "collideWithTetrominoes", "legacy", fixture, measure(opt, [] {},
+                [&](int) { sink = legacyCollideWithTetrominoes(legacyBoard, legacyPiece); }));
+
+            // updateScore mutates the board: every call gets a fresh copy,
+            // prepared outside the timed region. The current code only looks at
+            // the rows a locked piece can touch, here the bottom four.
+            std::vector<Game> games(opt.batch, game);
+            std::vector<LegacyBoard> boards(opt.batch);
+            report(opt, "updateScore", "current", fixture, measure(opt,
+                [&] { std::fill(games.begin(), games.end(), game); },
+                [&](int i) {
+                    games[i].updateScore(BOARD_HEIGHT - 4, BOARD_HEIGHT - 1);
+                    sink = games[i].score;
+                }));
+            report(opt, "updateScore", "legacy", fixture, measure(opt,
+                [&] { for (LegacyBoard &b : boards) memcpy(b.cells, legacyBoard, sizeof(b.cells)); },
+                [&](int i) { sink = legacyUpdateScore(boards[i].cells); }));
+
+            // cloning a whole game state, as search and replay seeking do
+            std::vector<Snapshot> snapshots(opt.batch);
+            SnapshotArena arena(opt.batch);
+            Snapshot saved;
+            game.save(saved);
+            LegacyGame legacyGame = {};
+            std::vector<LegacyGame> legacyGames(opt.batch);
+            report(opt, "clone", "save", fixture, measure(opt, [] {},
+                [&](int i) { game.save(snapshots[i]); sink = snapshots[i].score; }));
+            report(opt, "clone", "restore", fixture, measure(opt, [] {},
+                [&](int i) { games[i].restore(saved); sink = games[i].score; }));
+            report(opt, "clone", "arena", fixture, measure(opt, [&] { arena.reset(); },
+                [&](int) { Snapshot *s = arena.alloc(); game.save(*s); sink = s->score; }));
+            report(opt, "clone", "legacy", fixture, measure(opt, [] {},
+                [&](int i) { legacyGames[i] = legacyGame; sink = legacyGames[i].score; }));
+
+            // the AI's evaluation inputs, one kernel pass over the whole
+            // batch (timed as the first call) and reported per board
+            std::vector<Bitboard> batch(opt.batch, game.board);
+            std::vector<BoardFeatures> features(opt.batch);
+            report(opt, "features", "scalar", fixture, measure(opt, [] {},
+                [&](int i) {
+                    if (i == 0) boardFeatures(batch.data(), batch.size(), features.data());
+                    sink = features[i].cells;
+                }));
+
+            report(opt, "render", "full", fixture, measure(opt, [] {},
+                [&](int) { renderer.invalidate(); sink = renderer.draw(game); }));
+            report(opt, "render", "idle", fixture, measure(opt, [] {},
+                [&](int) { sink = renderer.draw(game); }));
+        }
+        close(devnull);
+    }
+};
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [-w warmup] [-r reps] [-b batch] [-s seed]\n", argv0);
+}
+
+int main(int argc, char **argv) {
+    Options opt;
+    int c;
+    while ((c = getopt(argc, argv, "w:r:b:s:h")) != -1) {
+        switch (c) {
+            case 'w': opt.warmup = atoi(optarg); break;
+            case 'r': opt.reps = atoi(optarg); break;
+            case 'b': opt.batch = atoi(optarg); break;
+            case 's': opt.seed = strtoul(optarg, NULL, 0); break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (opt.reps < 1 || opt.batch < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    printf("op,variant,fixture,reps,batch,median_ns,p99_ns,median_cycles,p99_cycles\n");
+    MicroBench::run(opt);
+    return 0;
+}
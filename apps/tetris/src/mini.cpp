@@ -0,0 +1,171 @@
+#include <asm/ioctls.h>
+#include <asm/termbits.h>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <poll.h>
+#include <unistd.h>
+#include "framebuffer.h"
+#include "game.h"
+#include "keys.h"
+#include "minirt.h"
+#include "renderer.h"
+#include "term.h"
+
+// Minimal build (make mini): the interactive game and nothing else, on the
+// raw system calls of minirt.cpp instead of libc. No recording, AI, high
+// scores or input thread; --seed and --randomizer work as in the full build
+// and held keys repeat with the default DAS and ARR.
+
+static const long long NS_PER_MS = 1000000LL;
+static const long long NS_PER_SEC = 1000000000LL;
+
+// kernel termios, read and set with TCGETS/TCSETSF
+static struct termios saved;
+static bool haveTermios = false;
+
+static void ioctlTermios(unsigned int request, struct termios *t) {
+    sysCall(__NR_ioctl, STDIN_FILENO, request, reinterpret_cast<long>(t));
+}
+
+// enableRawMode without signal handlers to undo it: ISIG is off as well,
+// so ctrl-C arrives as a byte and quits like q
+static void enterRawMode(FrameBuffer &out) {
+    haveTermios = sysCall(__NR_ioctl, STDIN_FILENO, TCGETS, reinterpret_cast<long>(&saved)) == 0;
+    if (haveTermios) {
+        struct termios raw = saved;
+        raw.c_lflag &= ~(ECHO | ICANON | ISIG);
+        raw.c_cc[VMIN] = 0;
+        raw.c_cc[VTIME] = 0;
+        ioctlTermios(TCSETSF, &raw);
+    }
+    out.put(TERM_ALT_SCREEN_ENTER TERM_CURSOR_HIDE TERM_CLEAR);
+    out.flush();
+}
+
+static void leaveRawMode(FrameBuffer &out) {
+    if (haveTermios) ioctlTermios(TCSETSF, &saved);
+    out.put(TERM_SGR_RESET TERM_CURSOR_SHOW TERM_ALT_SCREEN_LEAVE);
+}
+
+// decimal, or hexadecimal after 0x, like strtoul(s, NULL, 0) on valid input
+static bool parseSeed(const char *s, unsigned int &seed) {
+    unsigned int base = 10;
+    if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+        base = 16;
+        s += 2;
+    }
+    if (*s == '\0') return false;
+    unsigned int value = 0;
+    for (; *s != '\0'; ++s) {
+        unsigned int digit;
+        if (*s >= '0' && *s <= '9') {
+            digit = *s - '0';
+        } else if (base == 16 && (*s | 0x20) >= 'a' && (*s | 0x20) <= 'f') {
+            digit = (*s | 0x20) - 'a' + 10;
+        } else {
+            return false;
+        }
+        value = value * base + digit;
+    }
+    seed = value;
+    return true;
+}
+
+static int usage(FrameBuffer &out, const char *argv0) {
+    out.put("usage: ");
+    out.put(argv0);
+    out.put(" [--seed N] [--randomizer uniform|bag]\n");
+    out.flush();
+    return 1;
+}
+
+int miniMain(int argc, char **argv) {
+    // messages and the terminal mode switches, frames use the renderer's
+    static FrameBuffer text(STDOUT_FILENO);
+    unsigned int seed = static_cast<unsigned int>(sysClockNs(CLOCK_REALTIME) / NS_PER_SEC);
+    RandomizerKind kind = RandomizerKind::Uniform;
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        bool valid = i + 1 < argc;
+        if (valid && strcmp(arg, "--seed") == 0) {
+            valid = parseSeed(argv[++i], seed);
+        } else if (valid && strcmp(arg, "--randomizer") == 0) {
+            valid = parseRandomizer(argv[++i], kind);
+        } else {
+            valid = false;
+        }
+        if (!valid) return usage(text, argv[0]);
+    }
+
+    Game game(seed, kind);
+    static Renderer renderer;
+    KeyDecoder decoder;
+    AutoRepeat repeat(167 * NS_PER_MS, 33 * NS_PER_MS);
+    enterRawMode(text);
+
+    // the full build's tasks in one loop: keys, auto shift, gravity, frame
+    bool quit = false;
+    bool input = true;
+    bool dirty = true;
+    long long deadline = sysClockNs(CLOCK_MONOTONIC) + gravityInterval(game.level);
+    while (true) {
+        if (dirty) {
+            renderer.draw(game);
+            dirty = false;
+        }
+        if (quit || game.isOver()) break;
+
+        long long wake = deadline;
+        long long shift = repeat.nextDeadline();
+        if (shift != 0 && shift < wake) wake = shift;
+        long long remaining = wake - sysClockNs(CLOCK_MONOTONIC);
+        if (remaining < 0) remaining = 0;
+        struct timespec timeout = {static_cast<time_t>(remaining / NS_PER_SEC),
+                                   static_cast<long>(remaining % NS_PER_SEC)};
+        struct pollfd stdinFd = {STDIN_FILENO, POLLIN, 0};
+        long ready = sysCall(__NR_ppoll, reinterpret_cast<long>(&stdinFd), input ? 1 : 0,
+                             reinterpret_cast<long>(&timeout), 0);
+        long long now = sysClockNs(CLOCK_MONOTONIC);
+
+        if (ready > 0) {
+            char bytes[64];
+            long n = sysCall(__NR_read, STDIN_FILENO, reinterpret_cast<long>(bytes), sizeof(bytes));
+            // stdin closed or failed, keep running on gravity only; an
+            // interrupted read is retried on the next pass
+            if (n == 0 || (n < 0 && n != -EINTR && n != -EAGAIN)) input = false;
+            KeyEvent key;
+            for (long i = 0; i < n && !quit; ++i) {
+                if (bytes[i] == '\003') {
+                    quit = true;
+                } else if (decoder.feed(bytes[i], key)) {
+                    if (key.quit) {
+                        quit = true;
+                    } else if (repeat.press(key.action, now)) {
+                        dirty |= game.step(key.action);
+                    }
+                }
+            }
+        }
+        Action held;
+        while (repeat.due(now, held)) dirty |= game.step(held);
+
+        if (now - deadline > NS_PER_SEC) deadline = now; // resync after a stall
+        while (now >= deadline && !game.isOver()) {
+            game.tick();
+            deadline += gravityInterval(game.level);
+            dirty = true;
+        }
+    }
+
+    leaveRawMode(text);
+    if (quit) {
+        text.put("Exiting Tetris. Goodbye!\n");
+    } else {
+        text.put("Game over! Score: ");
+        text.putInt(game.getScore());
+        text.put('\n');
+    }
+    text.flush();
+    return 0;
+}
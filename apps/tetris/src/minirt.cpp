@@ -0,0 +1,147 @@
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include "minirt.h"
+
+// _start: the kernel leaves argc, argv and envp on the stack; hand their
+// address to miniStart with the stack aligned for a call
+#if defined(__x86_64__)
+__asm__(".text\n"
+        ".global _start\n"
+        "_start:\n"
+        "  xor %rbp, %rbp\n"
+        "  mov %rsp, %rdi\n"
+        "  and $-16, %rsp\n"
+        "  call miniStart\n"
+        "  hlt\n");
+#elif defined(__riscv)
+__asm__(".text\n"
+        ".global _start\n"
+        "_start:\n"
+        ".option push\n"
+        ".option norelax\n"
+        "  lla gp, __global_pointer$\n"
+        ".option pop\n"
+        "  mv a0, sp\n"
+        "  andi sp, sp, -16\n"
+        "  call miniStart\n");
+#elif defined(__loongarch64)
+__asm__(".text\n"
+        ".global _start\n"
+        "_start:\n"
+        "  move $fp, $zero\n"
+        "  move $a0, $sp\n"
+        "  bstrins.d $sp, $zero, 3, 0\n"
+        "  bl miniStart\n");
+#endif
+
+typedef void (*Initializer)();
+extern "C" Initializer __init_array_start[] __attribute__((visibility("hidden")));
+extern "C" Initializer __init_array_end[] __attribute__((visibility("hidden")));
+
+extern "C" [[noreturn]] void miniStart(long *stack) {
+    int argc = static_cast<int>(stack[0]);
+    char **argv = reinterpret_cast<char**>(stack + 1);
+    for (Initializer *init = __init_array_start; init != __init_array_end; ++init) (*init)();
+    sysExit(miniMain(argc, argv));
+}
+
+void sysExit(int status) {
+    for (;;) sysCall(__NR_exit_group, status);
+}
+
+long long sysClockNs(int clock) {
+    struct timespec ts = {0, 0};
+    sysCall(__NR_clock_gettime, clock, reinterpret_cast<long>(&ts));
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// the libc functions the shared modules call, with libc's declarations;
+// errno is only ever read right after the failing call
+
+static int lastError;
+
+extern "C" int *__errno_location() noexcept {
+    return &lastError;
+}
+
+static long result(long ret) {
+    if (ret < 0 && ret > -4096) {
+        lastError = static_cast<int>(-ret);
+        return -1;
+    }
+    return ret;
+}
+
+extern "C" ssize_t read(int fd, void *buf, size_t count) {
+    return result(sysCall(__NR_read, fd, reinterpret_cast<long>(buf), static_cast<long>(count)));
+}
+
+extern "C" ssize_t write(int fd, const void *buf, size_t count) {
+    return result(sysCall(__NR_write, fd, reinterpret_cast<long>(buf), static_cast<long>(count)));
+}
+
+extern "C" ssize_t writev(int fd, const struct iovec *iov, int count) {
+    return result(sysCall(__NR_writev, fd, reinterpret_cast<long>(iov), count));
+}
+
+// the generic system call table (RISC-V, LoongArch) has only ppoll
+extern "C" int poll(struct pollfd *fds, nfds_t count, int timeoutMs) {
+    struct timespec timeout = {timeoutMs / 1000, (timeoutMs % 1000) * 1000000L};
+    return static_cast<int>(result(sysCall(__NR_ppoll, reinterpret_cast<long>(fds),
+                                           static_cast<long>(count),
+                                           timeoutMs < 0 ? 0 : reinterpret_cast<long>(&timeout), 0)));
+}
+
+// byte loops are enough at these sizes; the build keeps the compiler from
+// turning them back into calls to themselves
+
+extern "C" void *memcpy(void *to, const void *from, size_t n) noexcept {
+    unsigned char *d = static_cast<unsigned char*>(to);
+    const unsigned char *s = static_cast<const unsigned char*>(from);
+    while (n-- > 0) *d++ = *s++;
+    return to;
+}
+
+extern "C" void *memmove(void *to, const void *from, size_t n) noexcept {
+    unsigned char *d = static_cast<unsigned char*>(to);
+    const unsigned char *s = static_cast<const unsigned char*>(from);
+    if (d < s) {
+        while (n-- > 0) *d++ = *s++;
+    } else {
+        while (n-- > 0) d[n] = s[n];
+    }
+    return to;
+}
+
+extern "C" void *memset(void *to, int c, size_t n) noexcept {
+    unsigned char *d = static_cast<unsigned char*>(to);
+    while (n-- > 0) *d++ = static_cast<unsigned char>(c);
+    return to;
+}
+
+extern "C" int memcmp(const void *a, const void *b, size_t n) noexcept {
+    const unsigned char *x = static_cast<const unsigned char*>(a);
+    const unsigned char *y = static_cast<const unsigned char*>(b);
+    for (; n > 0; --n, ++x, ++y) {
+        if (*x != *y) return *x - *y;
+    }
+    return 0;
+}
+
+extern "C" size_t strlen(const char *s) noexcept {
+    size_t n = 0;
+    while (s[n] != '\0') ++n;
+    return n;
+}
+
+extern "C" int strcmp(const char *a, const char *b) noexcept {
+    while (*a != '\0' && *a == *b) {
+        ++a;
+        ++b;
+    }
+    return static_cast<unsigned char>(*a) - static_cast<unsigned char>(*b);
+}
@@ -0,0 +1,51 @@
+#ifndef MINIRT_H
+#define MINIRT_H
+
+#include <asm/unistd.h>
+
+// Runtime of the minimal build (make mini): raw Linux system calls and the
+// handful of libc entry points the engine and renderer call, in place of
+// libc, libstdc++ and their startup code. _start (minirt.cpp) runs the
+// static constructors, calls miniMain() and exits with its result.
+
+inline long sysCall(long number, long a = 0, long b = 0, long c = 0, long d = 0) {
+#if defined(__x86_64__)
+    long ret;
+    register long r10 __asm__("r10") = d;
+    __asm__ volatile("syscall"
+                     : "=a"(ret)
+                     : "a"(number), "D"(a), "S"(b), "d"(c), "r"(r10)
+                     : "rcx", "r11", "memory");
+    return ret;
+#elif defined(__riscv)
+    register long a7 __asm__("a7") = number;
+    register long a0 __asm__("a0") = a;
+    register long a1 __asm__("a1") = b;
+    register long a2 __asm__("a2") = c;
+    register long a3 __asm__("a3") = d;
+    __asm__ volatile("ecall" : "+r"(a0) : "r"(a7), "r"(a1), "r"(a2), "r"(a3) : "memory");
+    return a0;
+#elif defined(__loongarch64)
+    register long a7 __asm__("$a7") = number;
+    register long a0 __asm__("$a0") = a;
+    register long a1 __asm__("$a1") = b;
+    register long a2 __asm__("$a2") = c;
+    register long a3 __asm__("$a3") = d;
+    __asm__ volatile("syscall 0"
+                     : "+r"(a0)
+                     : "r"(a7), "r"(a1), "r"(a2), "r"(a3)
+                     : "$t0", "$t1", "$t2", "$t3", "$t4", "$t5", "$t6", "$t7", "$t8", "memory");
+    return a0;
+#else
+#error "minirt: no system call sequence for this architecture"
+#endif
+}
+
+// the program's main(), which ISO C++ does not let _start call
+int miniMain(int, char**);
+
+[[noreturn]] void sysExit(int);
+// clock_gettime without the vDSO, in nanoseconds
+long long sysClockNs(int clock);
+
+#endif
@@ -0,0 +1,68 @@
+#include <cstring>
+#include "randomizer.h"
+
+Pcg32::Pcg32(uint64_t seed, uint64_t stream) : state(0), inc(stream << 1 | 1) {
+    next();
+    state += seed;
+    next();
+}
+
+uint32_t Pcg32::next() {
+    uint64_t old = state;
+    state = old * 6364136223846793005ULL + inc;
+    uint32_t xorshifted = static_cast<uint32_t>(((old >> 18) ^ old) >> 27);
+    uint32_t rot = static_cast<uint32_t>(old >> 59);
+    return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+}
+
+uint32_t Pcg32::below(uint32_t bound) {
+    // multiply-shift, the bias is below 2^-28 for bounds this small
+    return static_cast<uint32_t>((static_cast<uint64_t>(next()) * bound) >> 32);
+}
+
+Randomizer::Randomizer(uint32_t seed, RandomizerKind kind) : rng(seed), mode(kind) {}
+
+int Randomizer::nextType() {
+    if (mode == RandomizerKind::Uniform) return static_cast<int>(rng.below(7));
+    if (bagLeft == 0) {
+        // Fisher-Yates over a fresh bag
+        for (int i = 0; i < 7; ++i) bag[i] = static_cast<uint8_t>(i);
+        for (int i = 6; i > 0; --i) {
+            int j = static_cast<int>(rng.below(i + 1));
+            uint8_t t = bag[i];
+            bag[i] = bag[j];
+            bag[j] = t;
+        }
+        bagLeft = 7;
+    }
+    return bag[--bagLeft];
+}
+
+void Randomizer::next(int &type, int &rotation) {
+    type = nextType();
+    rotation = static_cast<int>(rng.below(4));
+}
+
+bool Randomizer::valid() const {
+    if (mode != RandomizerKind::Uniform && mode != RandomizerKind::Bag) return false;
+    if (bagLeft > 7) return false;
+    for (int i = 0; i < bagLeft; ++i) {
+        if (bag[i] >= 7) return false;
+    }
+    return true;
+}
+
+bool parseRandomizer(const char *name, RandomizerKind &kind) {
+    if (strcmp(name, "uniform") == 0) {
+        kind = RandomizerKind::Uniform;
+    } else if (strcmp(name, "bag") == 0) {
+        kind = RandomizerKind::Bag;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* randomizerName(RandomizerKind kind) {
+    return kind == RandomizerKind::Bag ? "bag" : "uniform";
+}
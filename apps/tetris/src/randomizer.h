@@ -0,0 +1,89 @@
+#ifndef RANDOMIZER_H
+#define RANDOMIZER_H
+
+#include <cstdint>
+
+// PCG32 (XSH RR variant): 16 bytes of state, seeding is two steps
+class Pcg32
+{
+public:
+    explicit Pcg32(uint64_t seed = 0, uint64_t stream = 0);
+    uint32_t next();
+    // uniform in [0, bound)
+    uint32_t below(uint32_t);
+
+private:
+    uint64_t state;
+    uint64_t inc;
+};
+
+// How piece types are drawn. Rotations are uniform under both.
+enum class RandomizerKind : uint8_t
+{
+    Uniform, // every type is equally likely on every draw
+    Bag      // shuffled bags of all seven types
+};
+
+// Piece source of a game. A plain value with no virtual dispatch, so it
+// can live inside a Snapshot.
+class Randomizer
+{
+public:
+    Randomizer() = default;
+    Randomizer(uint32_t seed, RandomizerKind);
+    // type and spawn rotation of the next piece
+    void next(int&, int&);
+    RandomizerKind kind() const { return mode; }
+    // the bag holds piece types only, for values read back from a file
+    bool valid() const;
+
+private:
+    int nextType();
+
+    Pcg32 rng;
+    RandomizerKind mode = RandomizerKind::Uniform;
+    uint8_t bag[7] = {};
+    uint8_t bagLeft = 0;
+};
+
+bool parseRandomizer(const char*, RandomizerKind&);
+const char* randomizerName(RandomizerKind);
+
+// Upcoming pieces in a fixed ring: popping the front and refilling the
+// slot it leaves are both O(1), and peek(i) needs no shifting.
+template <typename Piece, int N>
+class PreviewQueue
+{
+public:
+    void fill(Randomizer &source) {
+        for (int i = 0; i < N; ++i) slots[i] = draw(source);
+        head = 0;
+    }
+    const Piece& peek(int i) const { return slots[(head + i) % N]; }
+    bool valid() const {
+        if (head >= N) return false;
+        for (int i = 0; i < N; ++i) {
+            if (!slots[i].valid()) return false;
+        }
+        return true;
+    }
+    Piece pop(Randomizer &source) {
+        Piece front = slots[head];
+        slots[head] = draw(source);
+        head = (head + 1) % N;
+        return front;
+    }
+    static int size() { return N; }
+
+private:
+    static Piece draw(Randomizer &source) {
+        int type, rotation;
+        source.next(type, rotation);
+        return Piece(type, rotation);
+    }
+
+    Piece slots[N];
+    uint8_t head = 0;
+};
+
+#endif
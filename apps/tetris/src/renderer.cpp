@@ -0,0 +1,250 @@
+#include <algorithm>
+#include "renderer.h"
+#include "trace.h"
+
+// screen layout (1-based rows); each cell is two columns wide
+static const int LEVEL_ROW = BOARD_HEIGHT + 2;
+static const int SCORE_ROW = BOARD_HEIGHT + 3;
+static const int NEXT_LABEL_ROW = BOARD_HEIGHT + 4;
+static const int NEXT_ROW = BOARD_HEIGHT + 5;
+// below the parked cursor
+static const int STATUS_ROW = NEXT_ROW + 5;
+
+// frame buffer segments, submitted together with one writev()
+static const int BOARD_SEGMENT = 0;
+static const int HUD_SEGMENT = 1;
+
+// Color values are SGR color numbers (see tetrominoes.h), a cell is drawn
+// as blanks on background 40 + color. Empty cells and the ghost share the
+// default background, slot 0.
+static int cellSlot(uint8_t color) {
+    return color < GHOST ? color : 0;
+}
+
+static int slotBackground(int slot) {
+    return slot == 0 ? 0 : 40 + slot;
+}
+
+static char cellGlyph(uint8_t color) {
+    return color == GHOST ? ':' : ' ';
+}
+
+static int digits(int value) {
+    int n = 1;
+    while (value >= 10) {
+        value /= 10;
+        ++n;
+    }
+    return n;
+}
+
+// bytes of FrameBuffer::moveCursor
+static int moveCost(int row, int col) {
+    return 4 + digits(row) + digits(col);
+}
+
+// bytes of FrameBuffer::putCsi
+static int csiCost(int count) {
+    return count == 1 ? 3 : 3 + digits(count);
+}
+
+Renderer::Renderer(int fd) : out(fd) {}
+
+void Renderer::segment(int index) {
+    // segments go out in order, so cursor and SGR state carry across them
+    out.segment(index);
+}
+
+// Takes the shortest of an absolute jump and relative moves (CUU/CUD,
+// CUF/CUB or backspaces, CR) from a known position. Most jumps within a
+// frame are a row or two down to a nearby column.
+void Renderer::moveCursor(int row, int col) {
+    if (row == cursorRow && col == cursorCol) return;
+    if (cursorRow == 0) {
+        out.moveCursor(row, col);
+    } else {
+        int up = cursorRow - row;
+        int vertical = up == 0 ? 0 : csiCost(up > 0 ? up : -up);
+        int left = cursorCol - col;
+        int horizontal = left == 0 ? 0 : left < 0 ? csiCost(-left) : std::min(left, csiCost(left));
+        int fromStart = 1 + (col > 1 ? csiCost(col - 1) : 0);
+        if (vertical + std::min(horizontal, fromStart) >= moveCost(row, col)) {
+            out.moveCursor(row, col);
+        } else {
+            if (up > 0) out.putCsi(up, 'A');
+            if (up < 0) out.putCsi(-up, 'B');
+            if (horizontal <= fromStart) {
+                if (left < 0) {
+                    out.putCsi(-left, 'C');
+                } else if (left > 0 && left <= csiCost(left)) {
+                    while (left-- > 0) out.put('\b');
+                } else if (left > 0) {
+                    out.putCsi(left, 'D');
+                }
+            } else {
+                out.put('\r');
+                if (col > 1) out.putCsi(col - 1, 'C');
+            }
+        }
+    }
+    cursorRow = row;
+    cursorCol = col;
+}
+
+void Renderer::setBackground(int bg) {
+    if (bg == background) return;
+    if (bg == 0) {
+        out.put("\033[m");
+    } else {
+        out.put("\033[");
+        out.putInt(bg);
+        out.put('m');
+    }
+    background = bg;
+}
+
+void Renderer::putCell(int row, int col, uint8_t color) {
+    moveCursor(row, 2 * col + 1);
+    setBackground(slotBackground(cellSlot(color)));
+    char c = cellGlyph(color);
+    out.put(c);
+    out.put(c);
+    cursorCol += 2;
+}
+
+// Repaint the cells of one row that differ from `before` and use
+// background `slot` (every cell if -1). An unchanged gap of the same
+// background between two of them is rewritten when that is shorter than
+// stepping over it with CUF.
+void Renderer::putRow(int row, const uint8_t *cells, const uint8_t *before, int width,
+                      bool full, int slot) {
+    auto wanted = [&](int j) {
+        return (full || cells[j] != before[j]) && (slot < 0 || cellSlot(cells[j]) == slot);
+    };
+    int j = 0;
+    while (j < width) {
+        if (!wanted(j)) {
+            ++j;
+            continue;
+        }
+        putCell(row, j, cells[j]);
+        ++j;
+        int k = j;
+        while (k < width && !wanted(k) && cells[k] == before[k] && cellSlot(cells[k]) == slot) ++k;
+        if (k > j && k < width && wanted(k) && 2 * (k - j) < csiCost(2 * (k - j))) {
+            for (; j < k; ++j) putCell(row, j, cells[j]);
+        }
+    }
+}
+
+// Repaint the changed cells of a grid one background at a time, starting
+// with the one already in effect, so a frame switches SGR at most once per
+// color in it instead of once per color boundary. A full repaint goes in
+// plain row order.
+void Renderer::putGrid(int firstRow, const uint8_t *cells, const uint8_t *before, int rows,
+                       int width, bool full) {
+    if (full) {
+        for (int i = 0; i < rows; ++i) {
+            putRow(firstRow + i, cells + i * width, before + i * width, width, true, -1);
+        }
+        return;
+    }
+    unsigned pending = 0;
+    for (int i = 0; i < rows * width; ++i) {
+        if (cells[i] != before[i]) pending |= 1u << cellSlot(cells[i]);
+    }
+    int slot = background > 40 ? background - 40 : 0;
+    while (pending != 0) {
+        if (!(pending & (1u << slot))) slot = __builtin_ctz(pending);
+        for (int i = 0; i < rows; ++i) {
+            putRow(firstRow + i, cells + i * width, before + i * width, width, false, slot);
+        }
+        pending &= ~(1u << slot);
+    }
+}
+
+size_t Renderer::drawStatus(const char *line) {
+    segment(HUD_SEGMENT);
+    moveCursor(STATUS_ROW, 1);
+    setBackground(0);
+    out.put(line);
+    out.put("\033[K");
+    out.moveCursor(NEXT_ROW + 4, 1);
+    cursorRow = 0;
+    return out.flush();
+}
+
+size_t Renderer::draw(const Game &game) {
+    Frame frame;
+    for (int i = 0; i < BOARD_HEIGHT; ++i) {
+        for (int j = 0; j < BOARD_WIDTH; ++j) {
+            frame.cells[i][j] = game.cellColor(i, j);
+        }
+    }
+    const Tetromino &piece = game.current();
+    int ghost = game.ghostTop();
+    for (int i = 0; i < 4; ++i) {
+        int row = ghost + i;
+        if (row < 0 || row >= BOARD_HEIGHT) continue;
+        RowMask mask = piece.rowMask(i);
+        for (int j = 0; j < BOARD_WIDTH; ++j) {
+            if (((mask >> j) & 1) && frame.cells[row][j] == 0) frame.cells[row][j] = GHOST;
+        }
+    }
+    const Tetromino &next = game.upcoming();
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            frame.next[i][j] = ((next.shapeMask(i) >> j) & 1) ? next.color() : 0;
+        }
+    }
+    frame.level = game.level;
+    frame.score = game.getScore();
+    return draw(frame);
+}
+
+size_t Renderer::draw(const Frame &frame) {
+    TRACE_SCOPE("render");
+    bool full = !drawn;
+
+    segment(BOARD_SEGMENT);
+    if (full) {
+        // 复位颜色 + 清屏 + 光标回到左上角, only on the first frame
+        out.put("\033[m\033[2J\033[H");
+        cursorRow = cursorCol = 1;
+        background = 0;
+    }
+    putGrid(1, &frame.cells[0][0], &shown.cells[0][0], BOARD_HEIGHT, BOARD_WIDTH, full);
+    bool boardChanged = out.size() != 0;
+
+    segment(HUD_SEGMENT);
+    if (full) {
+        moveCursor(NEXT_LABEL_ROW, 1);
+        setBackground(0);
+        out.put("Next:");
+        cursorRow = 0;
+    }
+    if (full || frame.level != shown.level) {
+        moveCursor(LEVEL_ROW, 1);
+        // text, and the \033[K after it, on the default background
+        setBackground(0);
+        out.put("Level: ");
+        out.putInt(frame.level + 1);
+        out.put("\033[K");
+        cursorRow = 0;
+    }
+    if (full || frame.score != shown.score) {
+        moveCursor(SCORE_ROW, 1);
+        setBackground(0);
+        out.put("Score: ");
+        out.putInt(frame.score);
+        out.put("\033[K");
+        cursorRow = 0;
+    }
+    putGrid(NEXT_ROW, &frame.next[0][0], &shown.next[0][0], 4, 4, full);
+    // park the cursor below the HUD so typed keys don't land on the board
+    if (boardChanged || out.size() != 0) moveCursor(NEXT_ROW + 4, 1);
+
+    shown = frame;
+    drawn = true;
+    return out.flush();
+}
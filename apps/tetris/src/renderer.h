@@ -0,0 +1,54 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <unistd.h>
+#include "framebuffer.h"
+#include "game.h"
+#include "tetromino.h"
+
+// cell value of the ghost piece, drawn where the falling piece would land
+const uint8_t GHOST = 8;
+
+// Everything that is shown on screen, as plain color values (0 = empty)
+struct Frame
+{
+    uint8_t cells[BOARD_HEIGHT][BOARD_WIDTH];
+    uint8_t next[4][4];
+    int level;
+    int score;
+};
+
+// Differential terminal renderer: keeps a shadow copy of the last frame it
+// drew and only repaints the cells and HUD fields that changed since then.
+// Cells are drawn as background-colored blanks; the current SGR state is
+// tracked across frames so a run of same-colored cells costs one escape.
+class Renderer
+{
+public:
+    explicit Renderer(int = STDOUT_FILENO);
+    // returns the number of bytes written to the terminal
+    size_t draw(const Frame&);
+    size_t draw(const Game&);
+    // replace the status line under the HUD
+    size_t drawStatus(const char*);
+    // forget the shadow frame, the next draw repaints the whole screen
+    void invalidate() { drawn = false; }
+
+private:
+    void moveCursor(int, int);
+    void putCell(int, int, uint8_t);
+    void putRow(int, const uint8_t*, const uint8_t*, int, bool, int);
+    void putGrid(int, const uint8_t*, const uint8_t*, int, int, bool);
+    void setBackground(int);
+    void segment(int);
+    FrameBuffer out;
+    Frame shown;
+    bool drawn = false;
+    // 1-based terminal position of the cursor, 0 if unknown
+    int cursorRow = 0;
+    int cursorCol = 0;
+    // SGR background in effect on the terminal, 0 = default, -1 if unknown
+    int background = -1;
+};
+
+#endif
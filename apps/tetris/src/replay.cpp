@@ -0,0 +1,287 @@
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "replay.h"
+
+static const char MAGIC[4] = {'T', 'T', 'R', 'P'};
+static const char INDEX_MAGIC[4] = {'T', 'T', 'R', 'I'};
+static const size_t HEADER_SIZE = sizeof(MAGIC) + 1 + 4 + 1;
+static const size_t TRAILER_SIZE = 3 * 4 + sizeof(INDEX_MAGIC);
+// byte offsets of the fields of an index entry
+static const size_t ENTRY_OFFSET = 0;
+static const size_t ENTRY_SKIP = 4;
+static const size_t ENTRY_PIECES = 8;
+static const size_t ENTRY_TICKS = 12;
+static const size_t ENTRY_CHECKSUM = 16;
+
+static uint32_t fnv1a(const void *bytes, size_t length) {
+    const uint8_t *p = static_cast<const uint8_t*>(bytes);
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i) hash = (hash ^ p[i]) * 16777619u;
+    return hash;
+}
+
+bool ReplayWriter::open(const char *path, uint32_t seed, RandomizerKind kind) {
+    close();
+    file = fopen(path, "wb");
+    if (file == NULL) return false;
+    written = 0;
+    for (size_t i = 0; i < sizeof(MAGIC); ++i) put(MAGIC[i]);
+    put(REPLAY_VERSION);
+    putU32(seed);
+    put(static_cast<uint8_t>(kind));
+    pendingTicks = 0;
+    totalTicks = 0;
+    nextKeyframe = REPLAY_KEYFRAME_PIECES;
+    index.clear();
+    keyframes.clear();
+    return true;
+}
+
+void ReplayWriter::put(uint8_t byte) {
+    fputc(byte, file);
+    ++written;
+}
+
+void ReplayWriter::putU32(uint32_t value) {
+    for (int i = 0; i < 4; ++i) put((value >> (8 * i)) & 0xff);
+}
+
+void ReplayWriter::putVarint(uint32_t value) {
+    while (value >= 0x80) {
+        put((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    put(value);
+}
+
+void ReplayWriter::action(Action action) {
+    if (file == NULL || action == Action::None) return;
+    putVarint(pendingTicks);
+    put(static_cast<uint8_t>(action));
+    pendingTicks = 0;
+}
+
+void ReplayWriter::keyframe(const Game &game) {
+    if (file == NULL || game.getPieces() < nextKeyframe) return;
+    Keyframe entry = {written, pendingTicks, static_cast<uint32_t>(game.getPieces()), totalTicks};
+    index.push_back(entry);
+    keyframes.emplace_back();
+    game.save(keyframes.back());
+    nextKeyframe = game.getPieces() + REPLAY_KEYFRAME_PIECES;
+}
+
+bool ReplayWriter::close() {
+    if (file == NULL) return true;
+    putVarint(pendingTicks);
+    put(REPLAY_END);
+    // the snapshots first, then the index and the trailer that locates it
+    for (const Snapshot &snapshot : keyframes) {
+        fwrite(&snapshot, sizeof(Snapshot), 1, file);
+        written += sizeof(Snapshot);
+    }
+    uint32_t indexAt = written;
+    for (size_t i = 0; i < index.size(); ++i) {
+        putU32(index[i].offset);
+        putU32(index[i].skip);
+        putU32(index[i].pieces);
+        putU32(index[i].ticks);
+        putU32(fnv1a(&keyframes[i], sizeof(Snapshot)));
+    }
+    putU32(static_cast<uint32_t>(index.size()));
+    putU32(sizeof(Snapshot));
+    putU32(indexAt);
+    for (size_t i = 0; i < sizeof(INDEX_MAGIC); ++i) put(INDEX_MAGIC[i]);
+    // put() leaves errors on the stream, fclose() reports the last flush
+    bool ok = !ferror(file);
+    ok = fclose(file) == 0 && ok;
+    file = NULL;
+    return ok;
+}
+
+bool ReplayReader::open(const char *path) {
+    close();
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    void *map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(HEADER_SIZE)) {
+        map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    // the mapping keeps the file referenced on its own
+    ::close(fd);
+    if (map == MAP_FAILED) return false;
+    data = static_cast<const uint8_t*>(map);
+    size = st.st_size;
+    // the events are decoded front to back
+    madvise(map, size, MADV_SEQUENTIAL);
+
+    bool valid = memcmp(data, MAGIC, sizeof(MAGIC)) == 0 &&
+                 data[4] >= 2 && data[4] <= REPLAY_VERSION &&
+                 data[9] <= static_cast<uint8_t>(RandomizerKind::Bag);
+    if (!valid) {
+        close();
+        return false;
+    }
+    gameSeed = getU32(5);
+    kind = static_cast<RandomizerKind>(data[9]);
+    pos = HEADER_SIZE;
+    skip = 0;
+    finished = false;
+    keyframes = 0;
+    entrySize = data[4] >= 4 ? 5 * 4 : 4 * 4;
+    if (data[4] >= 3) readIndex();
+    return true;
+}
+
+void ReplayReader::close() {
+    if (data != nullptr) munmap(const_cast<uint8_t*>(data), size);
+    data = nullptr;
+    size = 0;
+    keyframes = 0;
+}
+
+uint32_t ReplayReader::getU32(size_t at) const {
+    return data[at] | data[at + 1] << 8 | data[at + 2] << 16 |
+           static_cast<uint32_t>(data[at + 3]) << 24;
+}
+
+void ReplayReader::readIndex() {
+    keyframes = 0;
+    if (size < HEADER_SIZE + TRAILER_SIZE) return;
+    size_t trailer = size - TRAILER_SIZE;
+    if (memcmp(data + trailer + 12, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0) return;
+    uint32_t count = getU32(trailer);
+    uint32_t snapshotSize = getU32(trailer + 4);
+    indexAt = getU32(trailer + 8);
+    // recorded by a build with another Snapshot layout, or damaged
+    if (snapshotSize != sizeof(Snapshot)) return;
+    if (indexAt > trailer || (trailer - indexAt) / entrySize < count) return;
+    if (static_cast<uint64_t>(count) * sizeof(Snapshot) + HEADER_SIZE > indexAt) return;
+    keyframes = count;
+}
+
+bool ReplayReader::getVarint(uint32_t &value) {
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (pos >= size) return false;
+        uint8_t byte = data[pos++];
+        value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+bool ReplayReader::next(ReplayEvent &event) {
+    if (finished) return false;
+    if (!getVarint(event.ticks) || pos >= size || event.ticks < skip) {
+        finished = true;
+        return false;
+    }
+    event.ticks -= skip;
+    skip = 0;
+    uint8_t code = data[pos++];
+    event.end = code == REPLAY_END;
+    // no Action past HardDrop, the stream is corrupt like a cut-off varint
+    if (!event.end && code > static_cast<uint8_t>(Action::HardDrop)) {
+        finished = true;
+        return false;
+    }
+    event.action = event.end ? Action::None : static_cast<Action>(code);
+    if (event.end) finished = true;
+    return true;
+}
+
+bool ReplayReader::restore(size_t keyframe, Game &game) {
+    size_t entry = indexAt + keyframe * entrySize;
+    size_t snapshotAt = indexAt - (keyframes - keyframe) * sizeof(Snapshot);
+    uint32_t offset = getU32(entry + ENTRY_OFFSET);
+    // the events a keyframe resumes at lie before the first snapshot
+    if (offset < HEADER_SIZE || offset >= indexAt - keyframes * sizeof(Snapshot)) return false;
+    if (entrySize > ENTRY_CHECKSUM &&
+        fnv1a(data + snapshotAt, sizeof(Snapshot)) != getU32(entry + ENTRY_CHECKSUM)) {
+        return false;
+    }
+    // any other byte is a valid bool only after the checks below
+    if (data[snapshotAt + offsetof(Snapshot, over)] > 1) return false;
+    Snapshot snapshot;
+    memcpy(&snapshot, data + snapshotAt, sizeof(Snapshot));
+    if (!snapshot.valid() || snapshot.randomizer.kind() != kind) return false;
+    if (static_cast<uint32_t>(snapshot.pieces) != getU32(entry + ENTRY_PIECES)) return false;
+    game.restore(snapshot);
+    pos = offset;
+    skip = getU32(entry + ENTRY_SKIP);
+    finished = false;
+    return true;
+}
+
+uint32_t ReplayReader::restoreBefore(size_t field, uint32_t value, Game &game) {
+    // entries are in piece and tick order: the first one past value
+    size_t low = 0, high = keyframes;
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (getU32(indexAt + middle * entrySize + field) <= value) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    // a damaged keyframe falls back to the one before it, and the last
+    // resort is decoding from the start
+    for (size_t i = low; i-- > 0;) {
+        if (restore(i, game)) return getU32(indexAt + i * entrySize + ENTRY_TICKS);
+    }
+    return 0;
+}
+
+bool ReplayReader::decodeUntil(int piece, uint32_t ticks, uint32_t at, Game &game) {
+    while (game.getPieces() < piece && at < ticks) {
+        size_t from = pos;
+        uint32_t already = skip;
+        ReplayEvent event;
+        if (!next(event)) return false;
+        uint32_t run = 0;
+        while (run < event.ticks && game.getPieces() < piece && at < ticks) {
+            game.tick();
+            ++run;
+            ++at;
+        }
+        if (game.getPieces() >= piece || at >= ticks) {
+            // stopped inside this event, next() returns the rest of it
+            pos = from;
+            skip = already + run;
+            finished = false;
+            return true;
+        }
+        if (event.end) return false;
+        game.step(event.action);
+    }
+    return true;
+}
+
+bool ReplayReader::seek(int piece, Game &game) {
+    uint32_t at = restoreBefore(ENTRY_PIECES, static_cast<uint32_t>(piece), game);
+    return decodeUntil(piece, UINT32_MAX, at, game);
+}
+
+bool ReplayReader::seekTicks(uint32_t ticks, Game &game) {
+    uint32_t at = restoreBefore(ENTRY_TICKS, ticks, game);
+    return decodeUntil(INT_MAX, ticks, at, game);
+}
+
+ReplayResult fastForward(ReplayReader &reader, Game &game) {
+    ReplayResult result = {0, 0};
+    ReplayEvent event;
+    while (reader.next(event)) {
+        for (uint32_t i = 0; i < event.ticks; ++i) game.tick();
+        result.ticks += event.ticks;
+        if (event.end) break;
+        game.step(event.action);
+        result.actions += 1;
+    }
+    return result;
+}
@@ -0,0 +1,149 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "game.h"
+
+// Replay file layout (all integers little endian):
+//
+//   "TTRP"  magic
+//   u8      version
+//   u32     seed passed to Game
+//   u8      RandomizerKind (since version 2)
+//   events  varint(gravity ticks since previous event), u8 action
+//   end     varint(trailing gravity ticks), u8 REPLAY_END
+//
+// A game is fully determined by its seed and the order in which actions
+// and gravity ticks reach the engine, so this is all a replay records.
+// Version 3 appends a keyframe index after the end marker, so a viewer can
+// seek without decoding from the start:
+//
+//   keyframes  one raw Snapshot each
+//   index      per keyframe: u32 offset of the next event, u32 gravity ticks
+//              of that event already run, u32 pieces, u32 total ticks,
+//              u32 FNV-1a of the snapshot (since version 4)
+//   trailer    u32 keyframe count, u32 sizeof(Snapshot), u32 index offset,
+//              "TTRI"
+//
+// Keyframes are raw memory images. A reader whose Snapshot size differs
+// ignores them and decodes from the start as for version 2. A keyframe
+// whose checksum or fields don't hold up is skipped for the one before it.
+
+// version 1 replays were drawn from std::mt19937 and can't be reproduced
+const uint8_t REPLAY_VERSION = 4;
+const uint8_t REPLAY_END = 0xff;
+// pieces between two keyframes
+const int REPLAY_KEYFRAME_PIECES = 100;
+
+struct ReplayEvent
+{
+    uint32_t ticks;  // gravity ticks to run before the action
+    Action action;
+    bool end;        // no action, the recording stops after the ticks
+};
+
+class ReplayWriter
+{
+public:
+    ReplayWriter() = default;
+    ReplayWriter(const ReplayWriter&) = delete;
+    ReplayWriter& operator=(const ReplayWriter&) = delete;
+    ~ReplayWriter() { close(); }
+
+    bool open(const char*, uint32_t, RandomizerKind);
+    bool isOpen() const { return file != NULL; }
+    // call after each Game::tick() and before each Game::step()
+    void tick() {
+        ++pendingTicks;
+        ++totalTicks;
+    }
+    void action(Action);
+    // call after tick() and after Game::step(); keeps a snapshot every
+    // REPLAY_KEYFRAME_PIECES pieces
+    void keyframe(const Game&);
+    // write the end marker and the keyframe index, and close the file;
+    // false if any write since open() failed
+    bool close();
+
+private:
+    struct Keyframe
+    {
+        uint32_t offset;
+        uint32_t skip;
+        uint32_t pieces;
+        uint32_t ticks;
+    };
+
+    void put(uint8_t);
+    void putU32(uint32_t);
+    void putVarint(uint32_t);
+    FILE *file = NULL;
+    uint32_t written = 0;
+    uint32_t pendingTicks = 0;
+    uint32_t totalTicks = 0;
+    int nextKeyframe = REPLAY_KEYFRAME_PIECES;
+    std::vector<Keyframe> index;
+    std::vector<Snapshot> keyframes;
+};
+
+// Reads a replay through a read-only mmap of the whole file, so nothing is
+// copied out of the page cache.
+class ReplayReader
+{
+public:
+    ReplayReader() = default;
+    ReplayReader(const ReplayReader&) = delete;
+    ReplayReader& operator=(const ReplayReader&) = delete;
+    ~ReplayReader() { close(); }
+
+    bool open(const char*);
+    void close();
+    uint32_t seed() const { return gameSeed; }
+    RandomizerKind randomizer() const { return kind; }
+    // false once the end marker has been returned or the data is truncated
+    bool next(ReplayEvent&);
+    // usable keyframes in the index, 0 for version 2 files
+    size_t keyframeCount() const { return keyframes; }
+    // Bring `game`, fresh from seed() and randomizer(), to the moment its
+    // `piece`th piece spawns: restore the nearest keyframe at or before it
+    // and decode only from there. next() continues after that moment.
+    // False if the recording ends first.
+    bool seek(int piece, Game&);
+    // the same, to just after the `ticks`th gravity step; at level 1 a
+    // step is half a second of the recording
+    bool seekTicks(uint32_t ticks, Game&);
+
+private:
+    bool getVarint(uint32_t&);
+    void readIndex();
+    uint32_t getU32(size_t) const;
+    // restore the newest sound keyframe whose index field at byte `field`
+    // is at most `value`, returns the total ticks at that moment
+    uint32_t restoreBefore(size_t field, uint32_t value, Game&);
+    bool restore(size_t, Game&);
+    bool decodeUntil(int piece, uint32_t ticks, uint32_t at, Game&);
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+    size_t pos = 0;
+    // ticks of the next event already run by seek()
+    uint32_t skip = 0;
+    size_t keyframes = 0;
+    size_t indexAt = 0;
+    size_t entrySize = 0;
+    uint32_t gameSeed = 0;
+    RandomizerKind kind = RandomizerKind::Uniform;
+    bool finished = false;
+};
+
+struct ReplayResult
+{
+    uint64_t ticks;
+    uint64_t actions;
+};
+
+// run a whole replay through the engine as fast as possible
+ReplayResult fastForward(ReplayReader&, Game&);
+
+#endif
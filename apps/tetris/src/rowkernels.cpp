@@ -0,0 +1,23 @@
+#include "rowkernels.h"
+
+void boardFeatures(const Bitboard *boards, size_t count, BoardFeatures *out) {
+    for (size_t b = 0; b < count; ++b) {
+        const Bitboard &board = boards[b];
+        int height = 0, cells = 0, bumpiness = 0, top = 0;
+        for (int j = 0; j < BOARD_WIDTH; ++j) {
+            height += board.heights[j];
+            if (board.heights[j] > top) top = board.heights[j];
+            if (j > 0) {
+                int step = board.heights[j] - board.heights[j - 1];
+                bumpiness += step < 0 ? -step : step;
+            }
+        }
+        // the rows above the tallest column are empty
+        for (int i = BOARD_HEIGHT - top; i < BOARD_HEIGHT; ++i) {
+            cells += __builtin_popcount(board.rows[i]);
+        }
+        out[b].height = height;
+        out[b].cells = cells;
+        out[b].bumpiness = bumpiness;
+    }
+}
@@ -0,0 +1,20 @@
+#ifndef ROWKERNELS_H
+#define ROWKERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include "bitboard.h"
+
+// What the AI's evaluation reads off a board
+struct BoardFeatures
+{
+    int32_t height;    // sum of column heights
+    int32_t cells;     // filled cells; height - cells are the holes
+    int32_t bumpiness; // sum of height steps between columns
+};
+
+// Features of a batch of boards in one pass: the height map, then a
+// popcount of each row under the tallest column
+void boardFeatures(const Bitboard*, size_t, BoardFeatures*);
+
+#endif
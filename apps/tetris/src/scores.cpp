@@ -0,0 +1,264 @@
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "scores.h"
+
+static const char MAGIC[4] = {'T', 'T', 'H', 'S'};
+static const uint32_t VERSION = 1;
+static const size_t HEADER_SLOT = 512;
+static const size_t LOG_OFFSET = 2 * HEADER_SLOT;
+
+static uint32_t fnv1a(const void *bytes, size_t length) {
+    const uint8_t *p = static_cast<const uint8_t*>(bytes);
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i) hash = (hash ^ p[i]) * 16777619u;
+    return hash;
+}
+
+static uint32_t recordChecksum(const ScoreRecord &record) {
+    return fnv1a(&record, offsetof(ScoreRecord, checksum));
+}
+
+static size_t fileSize(uint32_t capacity) {
+    return LOG_OFFSET + static_cast<size_t>(capacity) * sizeof(ScoreRecord);
+}
+
+// write all of buffer at offset, resuming short writes
+static bool writeAt(int fd, const void *buffer, size_t length, off_t offset) {
+    const char *p = static_cast<const char*>(buffer);
+    while (length > 0) {
+        ssize_t n = pwrite(fd, p, length, offset);
+        if (n <= 0) return false;
+        p += n;
+        length -= n;
+        offset += n;
+    }
+    return true;
+}
+
+const char* defaultScorePath() {
+    static char path[512];
+    const char *home = getenv("HOME");
+    snprintf(path, sizeof(path), "%s/.tetris-scores", home != NULL && *home ? home : ".");
+    return path;
+}
+
+bool ScoreStore::open(const char *file) {
+    close();
+    path = file;
+    fd = ::open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return false;
+    // two games creating the store at once would both write a first header
+    struct stat st;
+    if (!lock() || fstat(fd, &st) != 0) {
+        close();
+        return false;
+    }
+    if (st.st_size == 0) {
+        // a new store: an empty log and a first header in slot 0
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.capacity = SCORE_LOG_CAPACITY;
+        header.nextSequence = 1;
+        slot = 1;
+        if (ftruncate(fd, fileSize(SCORE_LOG_CAPACITY)) != 0 || !writeHeader()) {
+            close();
+            return false;
+        }
+    }
+    if ((data == nullptr && !map()) || !loadHeader()) {
+        close();
+        return false;
+    }
+    flock(fd, LOCK_UN);
+    return true;
+}
+
+// Take the store's lock. A compaction by another process renames a new
+// file over the path, so a lock on the file this store has open may no
+// longer be the lock of the store: follow the path until they agree.
+bool ScoreStore::lock() {
+    for (;;) {
+        if (flock(fd, LOCK_EX) != 0) return false;
+        struct stat held, current;
+        if (fstat(fd, &held) != 0) return false;
+        if (stat(path, &current) == 0 && current.st_dev == held.st_dev &&
+            current.st_ino == held.st_ino) {
+            return true;
+        }
+        int replaced = ::open(path, O_RDWR);
+        if (replaced < 0) return false;
+        if (data != nullptr) munmap(const_cast<uint8_t*>(data), size);
+        data = nullptr;
+        size = 0;
+        // closing drops the stale lock
+        ::close(fd);
+        fd = replaced;
+    }
+}
+
+void ScoreStore::close() {
+    if (data != nullptr) munmap(const_cast<uint8_t*>(data), size);
+    data = nullptr;
+    size = 0;
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+}
+
+bool ScoreStore::map() {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(LOG_OFFSET)) return false;
+    // only the pages that are touched get read: the two header slots and
+    // at most one record
+    void *mapping = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) return false;
+    data = static_cast<const uint8_t*>(mapping);
+    size = st.st_size;
+    return true;
+}
+
+bool ScoreStore::loadHeader() {
+    // the newer of the two slots whose checksum holds
+    bool found = false;
+    for (int i = 0; i < 2; ++i) {
+        Header candidate;
+        memcpy(&candidate, data + i * HEADER_SLOT, sizeof(candidate));
+        if (memcmp(candidate.magic, MAGIC, sizeof(MAGIC)) != 0 || candidate.version != VERSION) continue;
+        if (candidate.checksum != fnv1a(&candidate, offsetof(Header, checksum))) continue;
+        if (candidate.count > candidate.capacity || candidate.tableSize > SCORE_TABLE_SIZE ||
+            fileSize(candidate.capacity) > size) {
+            continue;
+        }
+        if (!found || candidate.generation > header.generation) {
+            header = candidate;
+            slot = i;
+            found = true;
+        }
+    }
+    if (!found) return false;
+    // a record synced just before a crash, whose header never made it
+    if (header.count < header.capacity) {
+        ScoreRecord next;
+        memcpy(&next, data + LOG_OFFSET + header.count * sizeof(ScoreRecord), sizeof(next));
+        if (next.sequence == header.nextSequence && next.checksum == recordChecksum(next)) {
+            apply(next);
+            writeHeader();
+        }
+    }
+    return true;
+}
+
+// fold a record that is in the log into the header
+void ScoreStore::apply(const ScoreRecord &record) {
+    header.count += 1;
+    header.nextSequence = record.sequence + 1;
+    header.totals.sessions += 1;
+    header.totals.pieces += record.pieces;
+    header.totals.lines += record.lines;
+    // a game that scored nothing is counted but not ranked
+    if (record.score == 0) return;
+    int at = static_cast<int>(header.tableSize);
+    while (at > 0 && header.table[at - 1].score < record.score) --at;
+    if (at >= SCORE_TABLE_SIZE) return;
+    int last = header.tableSize < SCORE_TABLE_SIZE ? header.tableSize : SCORE_TABLE_SIZE - 1;
+    for (int i = last; i > at; --i) header.table[i] = header.table[i - 1];
+    header.table[at] = record;
+    if (header.tableSize < SCORE_TABLE_SIZE) header.tableSize += 1;
+}
+
+// into the other slot, so the current one survives a torn write
+bool ScoreStore::writeHeader() {
+    header.generation += 1;
+    header.checksum = fnv1a(&header, offsetof(Header, checksum));
+    int target = 1 - slot;
+    if (!writeAt(fd, &header, sizeof(header), target * HEADER_SLOT) || fdatasync(fd) != 0) {
+        return false;
+    }
+    slot = target;
+    return true;
+}
+
+int ScoreStore::record(uint32_t score, uint32_t lines, uint32_t pieces, int level) {
+    if (fd < 0 || !lock()) return -1;
+    int rank = append(score, lines, pieces, level);
+    flock(fd, LOCK_UN);
+    return rank;
+}
+
+int ScoreStore::append(uint32_t score, uint32_t lines, uint32_t pieces, int level) {
+    // other games may have appended or compacted since this one read the
+    // header, minutes ago
+    if ((data == nullptr && !map()) || !loadHeader()) return -1;
+    if (header.count == header.capacity && !compact()) return -1;
+    ScoreRecord record = {};
+    record.sequence = header.nextSequence;
+    record.score = score;
+    record.lines = lines;
+    record.pieces = pieces;
+    record.endedAt = static_cast<int64_t>(time(nullptr));
+    record.level = static_cast<uint16_t>(level);
+    record.checksum = recordChecksum(record);
+    // the record is durable before any header counts it
+    off_t at = LOG_OFFSET + static_cast<off_t>(header.count) * sizeof(ScoreRecord);
+    if (!writeAt(fd, &record, sizeof(record), at) || fdatasync(fd) != 0) return -1;
+    apply(record);
+    if (!writeHeader()) return -1;
+    for (uint32_t i = 0; i < header.tableSize; ++i) {
+        if (header.table[i].sequence == record.sequence) return static_cast<int>(i) + 1;
+    }
+    return 0;
+}
+
+// Rewrite the store with the newest quarter of the log into a temporary
+// file and rename it over the old one. Totals and the top table already
+// live in the header, so nothing they summarize is lost.
+bool ScoreStore::compact() {
+    uint32_t keep = header.capacity / 4;
+    uint32_t from = header.count - keep;
+    char temporary[600];
+    snprintf(temporary, sizeof(temporary), "%s.tmp", path);
+    int out = ::open(temporary, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (out < 0) return false;
+    bool ok = ftruncate(out, fileSize(header.capacity)) == 0 &&
+              writeAt(out, data + LOG_OFFSET + from * sizeof(ScoreRecord),
+                      keep * sizeof(ScoreRecord), LOG_OFFSET);
+    Header compacted = header;
+    compacted.count = keep;
+    compacted.generation += 1;
+    compacted.checksum = fnv1a(&compacted, offsetof(Header, checksum));
+    ok = ok && writeAt(out, &compacted, sizeof(compacted), 0) && fsync(out) == 0;
+    // locked before it becomes the store, so a game that opens it next
+    // waits for this record
+    ok = ok && flock(out, LOCK_EX) == 0;
+    if (!ok || rename(temporary, path) != 0) {
+        ::close(out);
+        unlink(temporary);
+        return false;
+    }
+    // make the rename itself durable
+    const char *slash = strrchr(path, '/');
+    char directory[512];
+    snprintf(directory, sizeof(directory), "%.*s",
+             slash != NULL ? static_cast<int>(slash - path) + 1 : 1, slash != NULL ? path : ".");
+    int dir = ::open(directory, O_RDONLY);
+    if (dir >= 0) {
+        fsync(dir);
+        ::close(dir);
+    }
+
+    munmap(const_cast<uint8_t*>(data), size);
+    data = nullptr;
+    ::close(fd);
+    fd = out;
+    header = compacted;
+    slot = 0;
+    return map();
+}
@@ -0,0 +1,109 @@
+#ifndef SCORES_H
+#define SCORES_H
+
+#include <cstddef>
+#include <cstdint>
+
+// One finished game, a fixed 32-byte log record
+struct ScoreRecord
+{
+    uint32_t sequence;  // 1-based and never reused, 0 marks an empty slot
+    uint32_t score;
+    uint32_t lines;
+    uint32_t pieces;
+    int64_t endedAt;    // unix time
+    uint16_t level;
+    uint16_t flags;
+    uint32_t checksum;  // FNV-1a over the fields above
+};
+
+static_assert(sizeof(ScoreRecord) == 32, "score records are 32 bytes on disk");
+
+const int SCORE_TABLE_SIZE = 10;
+// records the log holds before it is compacted
+const uint32_t SCORE_LOG_CAPACITY = 1024;
+
+// File layout (native byte order, like replay keyframes):
+//
+//   header slot 0   512 bytes
+//   header slot 1   512 bytes
+//   log             SCORE_LOG_CAPACITY records
+//
+// A header holds a generation number, the number of records in the log,
+// the cumulative totals and the top-N table, followed by its checksum.
+// Appending a game writes and syncs its record first, then the header into
+// the slot the current one is not in: a crash at any point leaves one
+// intact header. Opening only reads the two header slots and, to roll
+// forward a record whose header update was lost, the record right after
+// the log end; the rest of the log is never read. A full log is compacted
+// into a fresh file that keeps the newest quarter of the records, which
+// then replaces the old one with rename().
+//
+// Several games may share a store: open(), record() and the compaction in
+// it hold flock(LOCK_EX) on the file, and record() rereads the header
+// under the lock before it appends.
+struct ScoreTotals
+{
+    uint64_t sessions;
+    uint64_t pieces;
+    uint64_t lines;
+};
+
+class ScoreStore
+{
+public:
+    ScoreStore() = default;
+    ScoreStore(const ScoreStore&) = delete;
+    ScoreStore& operator=(const ScoreStore&) = delete;
+    ~ScoreStore() { close(); }
+
+    // open or create the store at path
+    bool open(const char*);
+    void close();
+    bool isOpen() const { return fd >= 0; }
+    // append a finished game; its place in the top table (1-based), 0 if
+    // it didn't make it, -1 if the store could not be written
+    int record(uint32_t score, uint32_t lines, uint32_t pieces, int level);
+    const ScoreTotals& totals() const { return header.totals; }
+    int tableSize() const { return static_cast<int>(header.tableSize); }
+    const ScoreRecord& table(int i) const { return header.table[i]; }
+    uint32_t logSize() const { return header.count; }
+
+private:
+    struct Header
+    {
+        char magic[4];
+        uint32_t version;
+        uint64_t generation;
+        uint32_t capacity;
+        uint32_t count;
+        uint32_t nextSequence;
+        uint32_t tableSize;
+        ScoreTotals totals;
+        ScoreRecord table[SCORE_TABLE_SIZE];
+        uint32_t checksum;
+    };
+
+    static_assert(sizeof(Header) <= 512, "a header must fit its slot");
+
+    bool lock();
+    int append(uint32_t, uint32_t, uint32_t, int);
+    bool map();
+    bool loadHeader();
+    void apply(const ScoreRecord&);
+    bool writeHeader();
+    bool compact();
+
+    const char *path = nullptr;
+    int fd = -1;
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+    Header header = {};
+    // slot the current header was read from or last written to
+    int slot = 0;
+};
+
+// default store location, $HOME/.tetris-scores or ./.tetris-scores
+const char* defaultScorePath();
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef SHAPES_H
+#define SHAPES_H
+
+#include "board.h"
+#include "tetrominoes.h"
+
+// Geometry of a single (type, rotation), relative to the 4x4 shape origin
+struct Shape
+{
+    uint8_t rows[4];    // occupancy of each shape row, bit j is shape column j
+    int8_t minCol;      // leftmost occupied shape column
+    int8_t maxCol;      // rightmost occupied shape column
+    int8_t minRow;      // topmost occupied shape row
+    int8_t maxRow;      // bottommost occupied shape row
+    int8_t bottom[4];   // lowest occupied row of each shape column, -1 if empty
+    int8_t cells[4][2]; // (row, column) of the four blocks
+    uint8_t color;
+};
+
+struct ShapeTable
+{
+    Shape shapes[7][4];
+};
+
+constexpr Shape makeShape(int type, int rotation) {
+    Shape s{};
+    s.minCol = s.minRow = 4;
+    s.maxCol = s.maxRow = -1;
+    for (int j = 0; j < 4; ++j) s.bottom[j] = -1;
+    int n = 0;
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            int color = tetrominoes[type][rotation][i][j];
+            if (color == 0) continue;
+            s.rows[i] |= 1 << j;
+            if (j < s.minCol) s.minCol = j;
+            if (j > s.maxCol) s.maxCol = j;
+            if (i < s.minRow) s.minRow = i;
+            if (i > s.maxRow) s.maxRow = i;
+            s.bottom[j] = i;
+            s.cells[n][0] = i;
+            s.cells[n][1] = j;
+            s.color = color;
+            ++n;
+        }
+    }
+    return s;
+}
+
+constexpr ShapeTable makeShapeTable() {
+    ShapeTable table{};
+    for (int t = 0; t < 7; ++t) {
+        for (int r = 0; r < 4; ++r) {
+            table.shapes[t][r] = makeShape(t, r);
+        }
+    }
+    return table;
+}
+
+constexpr ShapeTable shapeTable = makeShapeTable();
+
+constexpr bool allShapesHaveFourBlocks() {
+    for (int t = 0; t < 7; ++t) {
+        for (int r = 0; r < 4; ++r) {
+            int blocks = 0;
+            for (int i = 0; i < 4; ++i) {
+                for (int j = 0; j < 4; ++j) {
+                    blocks += (shapeTable.shapes[t][r].rows[i] >> j) & 1;
+                }
+            }
+            if (blocks != 4) return false;
+        }
+    }
+    return true;
+}
+
+static_assert(allShapesHaveFourBlocks(), "tetrominoes must have four blocks");
+
+#endif
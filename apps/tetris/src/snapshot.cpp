@@ -0,0 +1,8 @@
+#include "snapshot.h"
+
+SnapshotArena::SnapshotArena(size_t capacity) : slots(capacity) {}
+
+Snapshot* SnapshotArena::alloc() {
+    if (used == slots.size()) return nullptr;
+    return &slots[used++];
+}
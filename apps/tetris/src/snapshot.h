@@ -0,0 +1,73 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+#include "bitboard.h"
+#include "randomizer.h"
+#include "tetromino.h"
+
+// pieces a game knows in advance, beyond the falling one
+const int PREVIEW_SIZE = 5;
+
+// The complete state of a Game as one trivially copyable block: saving or
+// restoring it is a plain memcpy, and nothing in it points anywhere.
+template <int Width, int Height>
+struct BasicSnapshot
+{
+    // row masks and column heights
+    BasicBitboard<Width, Height> board = {};
+    // color of each occupied cell, only read by render
+    uint8_t colors[Height][Width] = {};
+    int level = 0;
+    int completedRows = 0;
+    int score = 0;
+    int pieces = 0;
+    bool over = false;
+    BasicTetromino<Width, Height> tetromino;
+    PreviewQueue<BasicTetromino<Width, Height>, PREVIEW_SIZE> preview;
+    Randomizer randomizer;
+
+    // every field in range, for snapshots read back from a file; `over`
+    // must have been checked to be 0 or 1 before the bytes became a bool
+    bool valid() const {
+        for (int i = 0; i < Height; ++i) {
+            for (int j = 0; j < Width; ++j) {
+                if (colors[i][j] > 7) return false;
+            }
+        }
+        return board.valid() && level >= 0 && level <= 9 && completedRows >= 0 &&
+               score >= 0 && pieces >= 0 && tetromino.valid() && preview.valid() &&
+               randomizer.valid();
+    }
+};
+
+typedef BasicSnapshot<BOARD_WIDTH, BOARD_HEIGHT> Snapshot;
+
+static_assert(std::is_trivially_copyable<Snapshot>::value,
+              "Snapshot must stay copyable with memcpy");
+static_assert(std::is_standard_layout<Snapshot>::value,
+              "replay keyframes locate fields with offsetof");
+
+// Bump allocator of snapshots for search trees: the storage is reserved
+// once up front, alloc() never touches the heap, and a whole subtree is
+// released at once by rewinding to a mark() taken before it.
+class SnapshotArena
+{
+public:
+    explicit SnapshotArena(size_t capacity);
+    // nullptr once the arena is full
+    Snapshot* alloc();
+    size_t mark() const { return used; }
+    void rewind(size_t to) { used = to; }
+    void reset() { used = 0; }
+    size_t size() const { return used; }
+    size_t capacity() const { return slots.size(); }
+
+private:
+    std::vector<Snapshot> slots;
+    size_t used = 0;
+};
+
+#endif
@@ -0,0 +1,273 @@
+#include <arpa/inet.h>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "spectator.h"
+
+static const uint8_t PACKET_MAGIC = 'T';
+static const size_t HEADER_SIZE = 35;
+static const size_t MAX_PACKET = HEADER_SIZE + BOARD_HEIGHT * (2 + (BOARD_WIDTH + 1) / 2);
+
+void captureSpectator(const Game &game, SpectatorState &state) {
+    for (int i = 0; i < BOARD_HEIGHT; ++i) {
+        state.rows[i] = game.row(i);
+        for (int j = 0; j < BOARD_WIDTH; ++j) {
+            // only settled cells, the falling piece travels separately
+            state.colors[i][j] = ((state.rows[i] >> j) & 1) ? game.cellColor(i, j) : 0;
+        }
+    }
+    state.score = game.getScore();
+    state.lines = game.getLines();
+    state.pieces = game.getPieces();
+    state.level = static_cast<uint8_t>(game.level);
+    state.over = game.isOver();
+    const Tetromino &piece = game.current();
+    state.pieceType = piece.getType();
+    state.pieceRotation = piece.getRotation();
+    state.pieceLeft = piece.left();
+    state.pieceTop = piece.top();
+    state.ghostTop = game.ghostTop();
+    state.nextType = game.upcoming().getType();
+    state.nextRotation = game.upcoming().getRotation();
+}
+
+static void putPiece(Frame &frame, const Shape &shape, int top, int left, uint8_t color) {
+    for (int i = 0; i < 4; ++i) {
+        int row = top + i;
+        if (row < 0 || row >= BOARD_HEIGHT) continue;
+        for (int j = 0; j < 4; ++j) {
+            int col = left + j;
+            if (((shape.rows[i] >> j) & 1) && col >= 0 && col < BOARD_WIDTH &&
+                frame.cells[row][col] == 0) {
+                frame.cells[row][col] = color;
+            }
+        }
+    }
+}
+
+void spectatorFrame(const SpectatorState &state, Frame &frame) {
+    memcpy(frame.cells, state.colors, sizeof(frame.cells));
+    const Shape &piece = shapeTable.shapes[state.pieceType % 7][state.pieceRotation % 4];
+    if (!state.over) {
+        putPiece(frame, piece, state.pieceTop, state.pieceLeft, piece.color);
+        putPiece(frame, piece, state.ghostTop, state.pieceLeft, GHOST);
+    }
+    const Shape &next = shapeTable.shapes[state.nextType % 7][state.nextRotation % 4];
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            frame.next[i][j] = ((next.rows[i] >> j) & 1) ? next.color : 0;
+        }
+    }
+    frame.level = state.level;
+    frame.score = state.score;
+}
+
+static uint8_t *putU16(uint8_t *out, uint32_t value) {
+    out[0] = value & 0xff;
+    out[1] = (value >> 8) & 0xff;
+    return out + 2;
+}
+
+static uint8_t *putU32(uint8_t *out, uint32_t value) {
+    return putU16(putU16(out, value & 0xffff), value >> 16);
+}
+
+static uint32_t getU16(const uint8_t *in) {
+    return in[0] | in[1] << 8;
+}
+
+static uint32_t getU32(const uint8_t *in) {
+    return getU16(in) | getU16(in + 2) << 16;
+}
+
+// the rows of `now` that differ from `before`, all of them without one
+static size_t encode(const SpectatorState &now, const SpectatorState *before,
+                     uint32_t id, uint32_t sequence, uint8_t *packet) {
+    uint8_t *out = packet;
+    *out++ = PACKET_MAGIC;
+    *out++ = before == nullptr ? SPECTATOR_KEYFRAME : SPECTATOR_DELTA;
+    out = putU32(out, id);
+    out = putU32(out, sequence);
+    out = putU32(out, now.score);
+    out = putU32(out, now.lines);
+    out = putU32(out, now.pieces);
+    *out++ = now.level;
+    *out++ = now.over;
+    *out++ = now.pieceType;
+    *out++ = now.pieceRotation;
+    *out++ = static_cast<uint8_t>(now.pieceLeft);
+    *out++ = static_cast<uint8_t>(now.pieceTop);
+    *out++ = static_cast<uint8_t>(now.ghostTop);
+    *out++ = now.nextType;
+    *out++ = now.nextRotation;
+    uint32_t changed = 0;
+    for (int i = 0; i < BOARD_HEIGHT; ++i) {
+        bool same = before != nullptr && now.rows[i] == before->rows[i] &&
+                    memcmp(now.colors[i], before->colors[i], BOARD_WIDTH) == 0;
+        if (!same) changed |= 1u << i;
+    }
+    out = putU32(out, changed);
+    for (int i = 0; i < BOARD_HEIGHT; ++i) {
+        if (!(changed & (1u << i))) continue;
+        out = putU16(out, now.rows[i]);
+        int nibbles = 0;
+        for (int j = 0; j < BOARD_WIDTH; ++j) {
+            if (!((now.rows[i] >> j) & 1)) continue;
+            if (nibbles++ % 2 == 0) {
+                *out++ = now.colors[i][j] & 0x0f;
+            } else {
+                out[-1] |= (now.colors[i][j] & 0x0f) << 4;
+            }
+        }
+    }
+    return out - packet;
+}
+
+// apply a packet whose header was already checked
+static bool decode(const uint8_t *packet, size_t size, SpectatorState &state) {
+    const uint8_t *in = packet + 10;
+    const uint8_t *end = packet + size;
+    state.score = getU32(in);
+    state.lines = getU32(in + 4);
+    state.pieces = getU32(in + 8);
+    in += 12;
+    state.level = *in++;
+    state.over = *in++ != 0;
+    state.pieceType = *in++;
+    state.pieceRotation = *in++;
+    state.pieceLeft = static_cast<int8_t>(*in++);
+    state.pieceTop = static_cast<int8_t>(*in++);
+    state.ghostTop = static_cast<int8_t>(*in++);
+    state.nextType = *in++;
+    state.nextRotation = *in++;
+    uint32_t changed = getU32(in);
+    in += 4;
+    for (int i = 0; i < BOARD_HEIGHT; ++i) {
+        if (!(changed & (1u << i))) continue;
+        if (end - in < 2) return false;
+        RowMask mask = static_cast<RowMask>(getU16(in)) & FULL_ROW;
+        in += 2;
+        state.rows[i] = mask;
+        int nibbles = 0;
+        for (int j = 0; j < BOARD_WIDTH; ++j) {
+            state.colors[i][j] = 0;
+            if (!((mask >> j) & 1)) continue;
+            if (in >= end) return false;
+            state.colors[i][j] = nibbles++ % 2 == 0 ? *in & 0x0f : *in++ >> 4;
+        }
+        if (nibbles % 2 == 1) ++in;
+    }
+    return true;
+}
+
+bool Broadcaster::open(const char *hostPort, uint32_t gameId) {
+    close();
+    const char *colon = strrchr(hostPort, ':');
+    if (colon == NULL) return false;
+    char host[64];
+    size_t length = colon - hostPort;
+    if (length == 0 || length >= sizeof(host)) return false;
+    memcpy(host, hostPort, length);
+    host[length] = '\0';
+    int port = atoi(colon + 1);
+    if (port <= 0 || port > 65535) return false;
+    struct sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    if (strcmp(host, "localhost") == 0) strcpy(host, "127.0.0.1");
+    if (inet_pton(AF_INET, host, &address.sin_addr) != 1) return false;
+
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) return false;
+    // so a subnet broadcast address works as well as a single viewer
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on));
+    to = address;
+    id = gameId;
+    sequence = 0;
+    return true;
+}
+
+void Broadcaster::close() {
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+}
+
+void Broadcaster::send(const Game &game) {
+    if (fd < 0) return;
+    SpectatorState now;
+    // padding included, the states are compared with memcmp
+    memset(&now, 0, sizeof(now));
+    captureSpectator(game, now);
+    bool keyframe = sequence % SPECTATOR_KEYFRAME_INTERVAL == 0;
+    if (!keyframe && memcmp(&now, &last, sizeof(now)) == 0) return;
+    uint8_t packet[MAX_PACKET];
+    size_t size = encode(now, keyframe ? nullptr : &last, id, sequence, packet);
+    // a dropped packet is a gap the viewer notices, the game never waits
+    sendto(fd, packet, size, MSG_DONTWAIT, reinterpret_cast<const struct sockaddr*>(&to),
+           sizeof(to));
+    last = now;
+    ++sequence;
+    ++sentPackets;
+    sentBytes += size;
+    if (keyframe) ++sentKeyframes;
+}
+
+bool Spectator::open(int port) {
+    close();
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) return false;
+    int on = 1;
+    // several viewers on one host can watch the same broadcast
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    struct sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(fd, reinterpret_cast<const struct sockaddr*>(&address), sizeof(address)) != 0) {
+        close();
+        return false;
+    }
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    return true;
+}
+
+void Spectator::close() {
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+}
+
+bool Spectator::receive() {
+    uint8_t packet[MAX_PACKET + 1];
+    ssize_t size = recv(fd, packet, sizeof(packet), 0);
+    if (size < static_cast<ssize_t>(HEADER_SIZE) || size > static_cast<ssize_t>(MAX_PACKET) ||
+        packet[0] != PACKET_MAGIC) {
+        return false;
+    }
+    uint8_t kind = packet[1];
+    uint32_t packetId = getU32(packet + 2);
+    uint32_t packetSequence = getU32(packet + 6);
+    if (kind != SPECTATOR_KEYFRAME && kind != SPECTATOR_DELTA) return false;
+    // follow the first game heard from
+    if (!following) {
+        following = true;
+        id = packetId;
+    } else if (packetId != id) {
+        return false;
+    }
+    ++receivedPackets;
+    receivedBytes += size;
+    if (inSync && packetSequence != sequence + 1) {
+        // the packets in between are lost or late, only a keyframe helps
+        if (static_cast<int32_t>(packetSequence - sequence) > 0) {
+            lostPackets += packetSequence - sequence - 1;
+        }
+        inSync = false;
+    }
+    if (!inSync && kind != SPECTATOR_KEYFRAME) return false;
+    sequence = packetSequence;
+    inSync = decode(packet, size, current);
+    return inSync;
+}
@@ -0,0 +1,125 @@
+#ifndef SPECTATOR_H
+#define SPECTATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <netinet/in.h>
+#include "game.h"
+#include "renderer.h"
+
+// Spectator stream: one UDP datagram per state change. A delta packet only
+// carries the settled rows that changed since the previous packet; every
+// SPECTATOR_KEYFRAME_INTERVAL packets a keyframe carries all of them, so a
+// viewer that joins late (or lost a packet) syncs at the next keyframe.
+//
+// Packet layout (little endian):
+//
+//   u8   'T'
+//   u8   SPECTATOR_KEYFRAME or SPECTATOR_DELTA
+//   u32  game id, so a viewer sticks to one sender
+//   u32  sequence number, consecutive within a game
+//   u32  score, u32 lines, u32 pieces, u8 level, u8 game over
+//   u8   falling piece type, rotation, i8 left, i8 top, i8 ghost top
+//   u8   next piece type, rotation
+//   u32  bitmap of the rows that follow, bit i = playfield row i
+//   rows u16 occupancy mask, then one color nibble per occupied cell
+//        (low nibble first, padded to a byte)
+
+const uint8_t SPECTATOR_KEYFRAME = 1;
+const uint8_t SPECTATOR_DELTA = 2;
+const uint32_t SPECTATOR_KEYFRAME_INTERVAL = 64;
+
+static_assert(BOARD_HEIGHT <= 32, "the row bitmap is a u32");
+static_assert(BOARD_WIDTH <= 16, "row masks are sent as u16");
+
+// What a viewer needs to draw a game, with the settled board kept apart
+// from the falling piece
+struct SpectatorState
+{
+    RowMask rows[BOARD_HEIGHT];
+    uint8_t colors[BOARD_HEIGHT][BOARD_WIDTH];
+    uint32_t score;
+    uint32_t lines;
+    uint32_t pieces;
+    uint8_t level;
+    bool over;
+    uint8_t pieceType;
+    uint8_t pieceRotation;
+    int8_t pieceLeft;
+    int8_t pieceTop;
+    int8_t ghostTop;
+    uint8_t nextType;
+    uint8_t nextRotation;
+};
+
+void captureSpectator(const Game&, SpectatorState&);
+void spectatorFrame(const SpectatorState&, Frame&);
+
+// Sends a game's state changes to one address, which may be a broadcast
+// address. Sending never blocks; a full socket buffer drops the packet and
+// the viewer resyncs at the next keyframe.
+class Broadcaster
+{
+public:
+    Broadcaster() = default;
+    Broadcaster(const Broadcaster&) = delete;
+    Broadcaster& operator=(const Broadcaster&) = delete;
+    ~Broadcaster() { close(); }
+
+    // "host:port", host an IPv4 address or localhost; closes the socket of
+    // an earlier open(), and leaves none open if it fails
+    bool open(const char*, uint32_t gameId);
+    void close();
+    bool isOpen() const { return fd >= 0; }
+    // send a packet if anything a viewer draws changed since the last one
+    void send(const Game&);
+    uint64_t packets() const { return sentPackets; }
+    uint64_t bytes() const { return sentBytes; }
+    uint64_t keyframes() const { return sentKeyframes; }
+
+private:
+    int fd = -1;
+    struct sockaddr_in to = {};
+    uint32_t id = 0;
+    uint32_t sequence = 0;
+    SpectatorState last = {};
+    uint64_t sentPackets = 0;
+    uint64_t sentBytes = 0;
+    uint64_t sentKeyframes = 0;
+};
+
+// Receiving end: applies packets of one game to a SpectatorState
+class Spectator
+{
+public:
+    Spectator() = default;
+    Spectator(const Spectator&) = delete;
+    Spectator& operator=(const Spectator&) = delete;
+    ~Spectator() { close(); }
+
+    // closes the socket of an earlier open(), and leaves none open if it fails
+    bool open(int port);
+    void close();
+    int socketFd() const { return fd; }
+    // read one datagram; true if the state changed and is in sync
+    bool receive();
+    bool synced() const { return inSync; }
+    const SpectatorState& state() const { return current; }
+    uint64_t packets() const { return receivedPackets; }
+    uint64_t bytes() const { return receivedBytes; }
+    // packets missing between the ones received from the followed game
+    uint64_t lost() const { return lostPackets; }
+
+private:
+    int fd = -1;
+    bool following = false;
+    bool inSync = false;
+    uint32_t id = 0;
+    uint32_t sequence = 0;
+    SpectatorState current = {};
+    uint64_t receivedPackets = 0;
+    uint64_t receivedBytes = 0;
+    uint64_t lostPackets = 0;
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <atomic>
+#include <cstdint>
+
+// Wait-free single-producer/single-consumer ring of N slots (a power of
+// two). push() and pop() finish in a bounded number of steps and never
+// take a lock: the producer only writes `tail`, the consumer only `head`,
+// and the two indices sit on separate cache lines.
+template <typename T, uint32_t N>
+class SpscRing
+{
+    static_assert(N != 0 && (N & (N - 1)) == 0, "ring size must be a power of two");
+
+public:
+    // producer side; false if the ring is full
+    bool push(const T &value) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == N) return false;
+        slots[t & (N - 1)] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+    // consumer side; false if the ring is empty
+    bool pop(T &value) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        value = slots[h & (N - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+private:
+    // indices run freely and wrap at 2^32, which N divides
+    std::atomic<uint32_t> head{0};
+    char headPad[64 - sizeof(std::atomic<uint32_t>)];
+    std::atomic<uint32_t> tail{0};
+    char tailPad[64 - sizeof(std::atomic<uint32_t>)];
+    T slots[N];
+};
+
+#endif
@@ -0,0 +1,51 @@
+#include "stats.h"
+
+#ifdef TETRIS_STATS
+
+#include <algorithm>
+#include <ctime>
+
+SessionStats sessionStats;
+
+long long statsNow() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+long long Samples::percentile(double p) const {
+    if (values.empty()) return 0;
+    if (sorted != values.size()) {
+        std::sort(values.begin(), values.end());
+        sorted = values.size();
+    }
+    size_t index = static_cast<size_t>(p / 100.0 * (values.size() - 1) + 0.5);
+    return values[index];
+}
+
+void SessionStats::overlay(char *line, size_t size) const {
+    snprintf(line, size, "render p99 %lldus  latency p99 %lldus  gravity err p99 %lldus",
+             renderNs.percentile(99) / 1000, latencyNs.percentile(99) / 1000,
+             gravityErrorNs.percentile(99) / 1000);
+}
+
+static void row(FILE *out, const char *name, const Samples &samples, long long unit) {
+    fprintf(out, "%-22s %8zu %10lld %10lld %10lld %10lld\n", name, samples.count(),
+            samples.percentile(50) / unit, samples.percentile(95) / unit,
+            samples.percentile(99) / unit, samples.percentile(100) / unit);
+}
+
+void SessionStats::print(FILE *out) const {
+    fprintf(out, "%-22s %8s %10s %10s %10s %10s\n", "", "samples", "p50", "p95", "p99", "max");
+    row(out, "render (us)", renderNs, 1000);
+    row(out, "bytes/frame", bytes, 1);
+    row(out, "syscalls/frame", syscalls, 1);
+    row(out, "input latency (us)", latencyNs, 1000);
+    row(out, "read (us)", readNs, 1000);
+    row(out, "write (us)", writeNs, 1000);
+    row(out, "ppoll oversleep (us)", oversleepNs, 1000);
+    row(out, "gravity (us)", gravityNs, 1000);
+    row(out, "gravity error (us)", gravityErrorNs, 1000);
+}
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef STATS_H
+#define STATS_H
+
+// Session instrumentation for finding stutters: frame render time, bytes and
+// syscalls per frame, input-to-display latency, wakeup lateness and gravity
+// timing. Built only with -DTETRIS_STATS (make STATS=1); without the flag
+// STATS_ONLY() drops its argument and none of this exists.
+#ifdef TETRIS_STATS
+
+#define STATS_ONLY(...) __VA_ARGS__
+
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+// all samples of one quantity, percentiles are taken at report time
+class Samples
+{
+public:
+    Samples() { values.reserve(4096); }
+    void add(long long value) { values.push_back(value); }
+    size_t count() const { return values.size(); }
+    // p in [0, 100], 0 without samples
+    long long percentile(double) const;
+
+private:
+    mutable std::vector<long long> values;
+    mutable size_t sorted = 0;
+};
+
+struct SessionStats
+{
+    Samples renderNs;       // Renderer::draw including its write
+    Samples bytes;          // written per frame
+    Samples syscalls;       // issued since the previous frame
+    Samples latencyNs;      // key read until the frame showing it is written
+    Samples readNs;         // each read() of stdin
+    Samples writeNs;        // each write()/writev() of a frame
+    Samples oversleepNs;    // ppoll timeouts: wakeup past the deadline
+    Samples gravityNs;      // actual time between two gravity steps
+    Samples gravityErrorNs; // actual minus intended interval
+    unsigned long long pendingSyscalls = 0;
+
+    // one short line for the in-game overlay
+    void overlay(char*, size_t) const;
+    // p50/p95/p99 table of everything
+    void print(FILE*) const;
+};
+
+extern SessionStats sessionStats;
+
+// CLOCK_MONOTONIC in nanoseconds
+long long statsNow();
+
+#else
+
+#define STATS_ONLY(...)
+
+#endif
+
+#endif
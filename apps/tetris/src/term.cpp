@@ -0,0 +1,72 @@
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <termios.h>
+#include "term.h"
+
+static struct termios orig_termios;
+static bool haveTermios = false;
+static volatile sig_atomic_t rawEnabled = 0;
+
+void termWrite(const char *seq) {
+    size_t left = strlen(seq);
+    while (left > 0) {
+        ssize_t n = write(STDOUT_FILENO, seq, left);
+        if (n <= 0) return;
+        seq += n;
+        left -= n;
+    }
+}
+
+void clearScreen() {
+    termWrite(TERM_CLEAR);
+}
+
+void enterAltScreen() {
+    termWrite(TERM_ALT_SCREEN_ENTER);
+}
+
+void leaveAltScreen() {
+    termWrite(TERM_ALT_SCREEN_LEAVE);
+}
+
+void hideCursor() {
+    termWrite(TERM_CURSOR_HIDE);
+}
+
+void showCursor() {
+    termWrite(TERM_CURSOR_SHOW);
+}
+
+void disableRawMode() {
+    if (!rawEnabled) return;
+    rawEnabled = 0;
+    if (haveTermios) tcsetattr(STDIN_FILENO, TCSAFLUSH, &orig_termios);
+    termWrite(TERM_SGR_RESET TERM_CURSOR_SHOW TERM_ALT_SCREEN_LEAVE);
+}
+
+// restore the terminal when killed by ctrl-C instead of q
+static void onSignal(int sig) {
+    disableRawMode();
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+void enableRawMode() {
+    haveTermios = tcgetattr(STDIN_FILENO, &orig_termios) == 0;
+    if (haveTermios) {
+        struct termios raw = orig_termios;
+        raw.c_lflag &= ~(ECHO | ICANON); // 关闭回显，关闭行缓冲
+        // 等待由 ppoll 完成, read 只取已到达的字节
+        raw.c_cc[VMIN] = 0;
+        raw.c_cc[VTIME] = 0;
+        tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw);
+    }
+
+    rawEnabled = 1;
+    atexit(disableRawMode);
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    termWrite(TERM_ALT_SCREEN_ENTER TERM_CURSOR_HIDE TERM_CLEAR);
+}
@@ -0,0 +1,25 @@
+#ifndef TERM_H
+#define TERM_H
+
+// ANSI/xterm control sequences, literals so they can be concatenated
+#define TERM_CLEAR "\033[2J\033[H"
+#define TERM_ALT_SCREEN_ENTER "\033[?1049h"
+#define TERM_ALT_SCREEN_LEAVE "\033[?1049l"
+#define TERM_CURSOR_HIDE "\033[?25l"
+#define TERM_CURSOR_SHOW "\033[?25h"
+#define TERM_SGR_RESET "\033[m"
+
+// write a control sequence straight to stdout, bypassing stdio
+void termWrite(const char*);
+void clearScreen();
+void enterAltScreen();
+void leaveAltScreen();
+void hideCursor();
+void showCursor();
+
+// raw mode also switches to the alternate screen with the cursor hidden;
+// both transitions are a single write and disableRawMode is idempotent
+void enableRawMode();
+void disableRawMode();
+
+#endif
@@ -1,47 +1,23 @@
-#include <random>
-#include <ctime>  // 新增，用来获取时间戳
-
-#include "tetrominoes.h"
 #include "tetromino.h"
 
-Tetromino::Tetromino() {
-    static std::mt19937 gen(static_cast<unsigned int>(time(nullptr)));  // 用时间戳作为种子，静态只初始化一次
-    static std::uniform_int_distribution<> type_gen(0, 6);
-    static std::uniform_int_distribution<> rotation_gen(0, 3);
+template <int W, int H>
+BasicTetromino<W, H>::BasicTetromino(int type, int rotation) : rotation(rotation), type(type) {}
 
-    type = type_gen(gen);
-    rotation = rotation_gen(gen);
-    updateBoard();
+template <int W, int H>
+typename BasicTetromino<W, H>::Mask BasicTetromino<W, H>::rowMask(int i) const {
+    return shiftMask<Mask>(shape().rows[i], x);
 }
 
-
-void Tetromino::updateBoard() {
-    // update board with current x, y, type and rotation
-    for (int i = 0; i < 20 + 4; ++i) {
-        for (int j = 0; j < 10; ++j) {
-            if (i - y < 4 && i - y >= 0 &&
-                j - x < 4 && j - x >= 0) {
-                board[i][j] = tetrominoes[type][rotation][i - y][j - x];
-            } else {
-                board[i][j] = 0;
-            }
-        }
-    }
+template <int W, int H>
+bool BasicTetromino<W, H>::collideWithBorder() {
+    // O(1) extent check instead of redrawing the piece board
+    const Shape &extent = shape();
+    return x + extent.minCol < 0 || x + extent.maxCol >= W ||
+           y + extent.minRow < 0 || y + extent.maxRow >= H + HIDDEN_ROWS;
 }
 
-bool Tetromino::collideWithBorder() {
-    updateBoard();
-    int block = 0;
-    for (int i = 0; i < 20 + 4; ++i) {
-        for (int j = 0; j < 10; ++j) {
-            if (board[i][j] != 0) block += 1;
-        }
-    }
-    if (block < 4) return true;
-    return false;
-}
-
-bool Tetromino::moveRight() {
+template <int W, int H>
+bool BasicTetromino<W, H>::moveRight() {
     x += 1;
     if (collideWithBorder()) {
         x -= 1;
@@ -50,7 +26,8 @@ bool Tetromino::moveRight() {
     return true;
 }
 
-bool Tetromino::moveLeft() {
+template <int W, int H>
+bool BasicTetromino<W, H>::moveLeft() {
     x -= 1;
     if (collideWithBorder()) {
         x += 1;
@@ -59,7 +36,8 @@ bool Tetromino::moveLeft() {
     return true;
 }
 
-bool Tetromino::moveDown() {
+template <int W, int H>
+bool BasicTetromino<W, H>::moveDown() {
     y += 1;
     if (collideWithBorder()) {
         y -= 1;
@@ -68,7 +46,8 @@ bool Tetromino::moveDown() {
     return true;
 }
 
-bool Tetromino::moveUp() {
+template <int W, int H>
+bool BasicTetromino<W, H>::moveUp() {
     y -= 1;
     if (collideWithBorder()) {
         y += 1;
@@ -77,7 +56,8 @@ bool Tetromino::moveUp() {
     return true;
 }
 
-bool Tetromino::rotate(bool reverse) {
+template <int W, int H>
+bool BasicTetromino<W, H>::rotate(bool reverse) {
     if (reverse) rotation += 2;
     rotation = (rotation + 1) % 4;
     if (collideWithBorder()) {
@@ -86,3 +66,6 @@ bool Tetromino::rotate(bool reverse) {
     }
     return true;
 }
+
+#define INSTANTIATE_TETROMINO(W, H) template class BasicTetromino<W, H>;
+TETRIS_BOARD_SIZES(INSTANTIATE_TETROMINO)
@@ -1,24 +1,64 @@
 #ifndef TETROMINO_H
 #define TETROMINO_H
 
-class Tetromino
+#include <cstdint>
+#include <type_traits>
+#include "board.h"
+#include "shapes.h"
+
+// A falling piece is just its type, rotation and position; the cells come
+// from shapeTable on demand, so copying one is a 4-byte move. Instantiated
+// for TETRIS_BOARD_SIZES in tetromino.cpp.
+template <int Width, int Height>
+class BasicTetromino
 {
 public:
-    Tetromino();
-    void updateBoard();
+    static_assert(Height + HIDDEN_ROWS <= 127, "piece rows are stored in an int8_t");
+    typedef typename RowTraits<Width>::Mask Mask;
+
+    BasicTetromino() : BasicTetromino(0, 0) {}
+    BasicTetromino(int, int);
     bool moveRight();
     bool moveLeft();
     bool moveDown();
     bool moveUp();
     bool rotate(bool=false);
-    int board[24][10] = {};
+    // move down by a distance already known to be free
+    void shiftDown(int rows) { y += rows; }
+    // mask of the i-th row of the 4x4 shape, shifted to the current column
+    Mask rowMask(int) const;
+    // mask of the i-th row of the 4x4 shape, bit j is shape column j
+    unsigned shapeMask(int i) const { return shape().rows[i]; }
+    // playfield row of the first row of the 4x4 shape (may be negative)
+    int top() const { return y - HIDDEN_ROWS; }
+    // playfield column of the first column of the 4x4 shape (may be negative)
+    int left() const { return x; }
+    int color() const { return shape().color; }
+    int getType() const { return type; }
+    int getRotation() const { return rotation; }
+    const Shape& shape() const { return shapeTable.shapes[type][rotation]; }
+    // a known type and rotation with every block on the piece board, for
+    // values read back from a file
+    bool valid() const {
+        if (type < 0 || type >= 7 || rotation < 0 || rotation >= 4) return false;
+        const Shape &s = shape();
+        return x + s.minCol >= 0 && x + s.maxCol < Width &&
+               y + s.minRow >= 0 && y + s.maxRow < Height + HIDDEN_ROWS;
+    }
 
 private:
-    int y = 1;
-    int x = 3;
-    int rotation;
-    int type;
+    int8_t y = SPAWN_ROW;
+    int8_t x = spawnColumn(Width);
+    int8_t rotation;
+    int8_t type;
     bool collideWithBorder();
+    friend struct MicroBench;
 };
 
+typedef BasicTetromino<BOARD_WIDTH, BOARD_HEIGHT> Tetromino;
+
+static_assert(sizeof(Tetromino) == 4, "Tetromino should stay a 4-byte value");
+static_assert(std::is_trivially_copyable<Tetromino>::value,
+              "Tetromino is copied with plain moves");
+
 #endif
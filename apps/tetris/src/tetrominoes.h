@@ -9,7 +9,7 @@
 //              │  ┌ rotation
 //              │  │  ┌ height
 //              │  │  │  ┌ width
-int tetrominoes[7][4][4][4] = {
+constexpr int tetrominoes[7][4][4][4] = {
     {
         {
             {0, 0, 0, 0},
@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <ctime>
+#include <memory>
+#include "threadpool.h"
+#include "trace.h"
+
+static thread_local int workerIndex = -1;
+
+static uint64_t monotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+ThreadPool::ThreadPool(int threads) {
+    if (threads < 1) threads = 1;
+    for (int i = 0; i < threads; ++i) workers.push_back(new Worker);
+    for (int i = 0; i < threads; ++i) {
+        workers[i]->thread = std::thread(&ThreadPool::run, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(idleLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    // idle workers still probe each other's deques until they exit
+    for (Worker *worker : workers) worker->thread.join();
+    for (Worker *worker : workers) delete worker;
+}
+
+int ThreadPool::currentWorker() {
+    return workerIndex;
+}
+
+void ThreadPool::submit(Task task) {
+    int target = workerIndex >= 0
+        ? workerIndex
+        : static_cast<int>(nextWorker++ % workers.size());
+    unfinished++;
+    {
+        std::lock_guard<std::mutex> guard(workers[target]->lock);
+        workers[target]->tasks.push_back(std::move(task));
+    }
+    queued++;
+    // take idleLock so a worker about to sleep cannot miss the wakeup
+    { std::lock_guard<std::mutex> guard(idleLock); }
+    wake.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> guard(idleLock);
+    done.wait(guard, [this] { return unfinished.load() == 0; });
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)> &body) {
+    // shared with the helper tasks, which may only start after we returned
+    struct Batch
+    {
+        std::function<void(int)> body;
+        int count;
+        std::atomic<int> next{0};
+        std::atomic<int> finished{0};
+    };
+    std::shared_ptr<Batch> batch = std::make_shared<Batch>();
+    batch->body = body;
+    batch->count = count;
+    auto drain = [batch] {
+        int i;
+        while ((i = batch->next++) < batch->count) {
+            batch->body(i);
+            batch->finished++;
+        }
+    };
+
+    int helpers = std::min(count, size()) - 1;
+    for (int i = 0; i < helpers; ++i) submit(drain);
+    drain();
+    // the last indices may still run on helpers
+    while (batch->finished.load() < count) std::this_thread::yield();
+}
+
+ThreadPool::WorkerStats ThreadPool::stats(int index) const {
+    std::lock_guard<std::mutex> guard(workers[index]->lock);
+    return workers[index]->stats;
+}
+
+bool ThreadPool::pop(int self, Task &task) {
+    Worker *worker = workers[self];
+    std::lock_guard<std::mutex> guard(worker->lock);
+    if (worker->tasks.empty()) return false;
+    task = std::move(worker->tasks.back());
+    worker->tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(int self, Task &task) {
+    int n = size();
+    for (int k = 1; k < n; ++k) {
+        Worker *victim = workers[(self + k) % n];
+        std::lock_guard<std::mutex> guard(victim->lock);
+        if (victim->tasks.empty()) continue;
+        task = std::move(victim->tasks.front());
+        victim->tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::run(int self) {
+    workerIndex = self;
+    TRACE_ONLY(traceThreadName("worker");)
+    Worker *worker = workers[self];
+    while (true) {
+        Task task;
+        bool stolen = false;
+        if (!pop(self, task)) {
+            stolen = steal(self, task);
+            if (!stolen) {
+                std::unique_lock<std::mutex> guard(idleLock);
+                TRACE_SCOPE("idle");
+                wake.wait(guard, [this] { return stopping || queued.load() > 0; });
+                if (stopping && queued.load() == 0) return;
+                continue;
+            }
+        }
+        queued--;
+
+        uint64_t start = monotonicNs();
+        task();
+        uint64_t elapsed = monotonicNs() - start;
+        {
+            std::lock_guard<std::mutex> guard(worker->lock);
+            worker->stats.tasks += 1;
+            worker->stats.steals += stolen;
+            worker->stats.busyNs += elapsed;
+        }
+
+        if (--unfinished == 0) {
+            std::lock_guard<std::mutex> guard(idleLock);
+            done.notify_all();
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool. Every worker owns a deque: it pops its own
+// tasks from the back and, when empty, steals from the front of the other
+// workers' deques. Idle workers sleep on a condition variable.
+class ThreadPool
+{
+public:
+    typedef std::function<void()> Task;
+
+    struct WorkerStats
+    {
+        uint64_t tasks = 0;
+        uint64_t steals = 0;
+        uint64_t busyNs = 0;
+    };
+
+    explicit ThreadPool(int threads);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // queue a task; from a worker it goes to that worker's own deque
+    void submit(Task);
+    // block until every submitted task has finished
+    void wait();
+    // run body(0) .. body(count - 1) across the pool and return when all
+    // are done. The caller claims indices too, so this may be nested in a
+    // task without deadlocking the pool.
+    void parallelFor(int, const std::function<void(int)>&);
+    int size() const { return static_cast<int>(workers.size()); }
+    WorkerStats stats(int) const;
+    // index of the calling worker thread, -1 outside the pool
+    static int currentWorker();
+
+private:
+    // heap-allocated one by one so workers don't share cache lines
+    struct Worker
+    {
+        std::mutex lock;
+        std::deque<Task> tasks;
+        WorkerStats stats;
+        std::thread thread;
+    };
+
+    void run(int);
+    bool pop(int, Task&);
+    bool steal(int, Task&);
+
+    std::vector<Worker*> workers;
+    std::mutex idleLock;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::atomic<int> queued{0};
+    std::atomic<int> unfinished{0};
+    std::atomic<unsigned int> nextWorker{0};
+    bool stopping = false;
+};
+
+#endif
@@ -0,0 +1,115 @@
+#include "trace.h"
+
+#ifdef TETRIS_TRACE
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <unistd.h>
+
+struct TraceEventRecord
+{
+    const char *name;
+    long long start;
+    long long duration;
+};
+
+// written by its owning thread only; read by traceDump after the writers
+// are gone
+struct TraceRing
+{
+    const char *thread;
+    unsigned long long recorded;
+    TraceEventRecord events[TRACE_RING_EVENTS];
+};
+
+static TraceRing rings[TRACE_MAX_THREADS];
+static std::atomic<int> claimedRings{0};
+static thread_local TraceRing *ownRing = nullptr;
+static thread_local bool unrecorded = false;
+static const char *dumpPath = nullptr;
+
+static TraceRing* claimRing() {
+    if (ownRing == nullptr && !unrecorded) {
+        int index = claimedRings.fetch_add(1, std::memory_order_relaxed);
+        if (index < TRACE_MAX_THREADS) {
+            ownRing = &rings[index];
+        } else {
+            unrecorded = true;
+        }
+    }
+    return ownRing;
+}
+
+static void dumpAtExit() {
+    if (!traceDump(dumpPath)) perror(dumpPath);
+}
+
+long long traceNow() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void traceEvent(const char *name, long long start, long long end) {
+    TraceRing *own = claimRing();
+    if (own == nullptr) return;
+    TraceEventRecord &event = own->events[own->recorded % TRACE_RING_EVENTS];
+    event.name = name;
+    event.start = start;
+    event.duration = end - start;
+    own->recorded += 1;
+}
+
+void traceThreadName(const char *name) {
+    TraceRing *own = claimRing();
+    if (own != nullptr) own->thread = name;
+}
+
+bool traceDump(const char *path) {
+    FILE *out = fopen(path, "w");
+    if (out == NULL) return false;
+    int count = claimedRings.load();
+    if (count > TRACE_MAX_THREADS) count = TRACE_MAX_THREADS;
+
+    // timestamps count from the oldest event still in a ring
+    long long base = 0;
+    unsigned long long dropped = 0;
+    for (int r = 0; r < count; ++r) {
+        const TraceRing &ring = rings[r];
+        unsigned long long first = ring.recorded > TRACE_RING_EVENTS ? ring.recorded - TRACE_RING_EVENTS : 0;
+        dropped += first;
+        if (ring.recorded == 0) continue;
+        long long start = ring.events[first % TRACE_RING_EVENTS].start;
+        if (base == 0 || start < base) base = start;
+    }
+
+    int pid = static_cast<int>(getpid());
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped\":%llu},\"traceEvents\":[\n",
+            dropped);
+    bool comma = false;
+    for (int r = 0; r < count; ++r) {
+        const TraceRing &ring = rings[r];
+        fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+                     "\"args\":{\"name\":\"%s\"}}",
+                comma ? ",\n" : "", pid, r, ring.thread != nullptr ? ring.thread : "thread");
+        comma = true;
+        unsigned long long first = ring.recorded > TRACE_RING_EVENTS ? ring.recorded - TRACE_RING_EVENTS : 0;
+        for (unsigned long long i = first; i < ring.recorded; ++i) {
+            const TraceEventRecord &event = ring.events[i % TRACE_RING_EVENTS];
+            fprintf(out, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+                         "\"ts\":%.3f,\"dur\":%.3f}",
+                    event.name, pid, r, (event.start - base) / 1e3, event.duration / 1e3);
+        }
+    }
+    fprintf(out, "\n]}\n");
+    return fclose(out) == 0;
+}
+
+void traceDumpAtExit(const char *path) {
+    dumpPath = path;
+    atexit(dumpAtExit);
+}
+
+#endif
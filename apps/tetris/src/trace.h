@@ -0,0 +1,59 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Timeline of scoped trace points, to line up a stalled frame with what
+// every thread was doing at the time. Built only with -DTETRIS_TRACE (make
+// TRACE=1); without the flag TRACE_SCOPE() and TRACE_ONLY() drop their
+// argument and none of this exists.
+//
+// A thread records complete events (name, start, duration) into a ring of
+// its own, claimed from a static array the first time it records, so the
+// hot path is two clock reads and a store: no allocation, no lock and no
+// write to memory another thread writes. A full ring overwrites its oldest
+// events. traceDump() writes every ring as Chrome trace-event JSON, for
+// chrome://tracing or Perfetto, once the other threads have stopped.
+#ifdef TETRIS_TRACE
+
+#define TRACE_ONLY(...) __VA_ARGS__
+#define TRACE_JOIN2(a, b) a##b
+#define TRACE_JOIN(a, b) TRACE_JOIN2(a, b)
+// time the rest of the enclosing block; the name must be a string literal
+#define TRACE_SCOPE(name) TraceScope TRACE_JOIN(traceScope, __LINE__)(name)
+
+#include <cstddef>
+
+// threads beyond the first TRACE_MAX_THREADS are not recorded
+const int TRACE_MAX_THREADS = 16;
+const size_t TRACE_RING_EVENTS = 16384;
+
+// CLOCK_MONOTONIC in nanoseconds
+long long traceNow();
+void traceEvent(const char*, long long start, long long end);
+// label the calling thread in the dump, a string literal
+void traceThreadName(const char*);
+// write the recorded events to path, false if it could not be written
+bool traceDump(const char*);
+// traceDump(path) from an atexit handler; path must outlive it
+void traceDumpAtExit(const char*);
+
+class TraceScope
+{
+public:
+    explicit TraceScope(const char *name) : name(name), start(traceNow()) {}
+    ~TraceScope() { traceEvent(name, start, traceNow()); }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char *name;
+    long long start;
+};
+
+#else
+
+#define TRACE_ONLY(...)
+#define TRACE_SCOPE(name)
+
+#endif
+
+#endif
@@ -0,0 +1,57 @@
+#include <cstring>
+#include "transposition.h"
+
+// fixed key stream, so hashes (and slot collisions) are reproducible
+static uint64_t splitmix64(uint64_t &state) {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+TranspositionTable::TranspositionTable(int bits)
+    : slots(new Slot[size_t(1) << bits]), mask((uint64_t(1) << bits) - 1) {
+    uint64_t state = 0x5445545249535ULL;
+    for (int i = 0; i < BOARD_HEIGHT; ++i) {
+        for (int j = 0; j < BOARD_WIDTH; ++j) cells[i][j] = splitmix64(state);
+    }
+    for (int t = 0; t < 7; ++t) {
+        for (int r = 0; r < 4; ++r) pieces[t][r] = splitmix64(state);
+    }
+    clear();
+}
+
+uint64_t TranspositionTable::key(const Bitboard &board) const {
+    uint64_t hash = 0;
+    for (int i = 0; i < BOARD_HEIGHT; ++i) {
+        for (unsigned row = board.rows[i]; row != 0; row &= row - 1) {
+            hash ^= cells[i][__builtin_ctz(row)];
+        }
+    }
+    return hash;
+}
+
+bool TranspositionTable::probe(uint64_t key, double &value) const {
+    const Slot &slot = slots[key & mask];
+    uint64_t check = slot.check.load(std::memory_order_relaxed);
+    uint64_t data = slot.data.load(std::memory_order_relaxed);
+    if ((check ^ data) != key) return false;
+    memcpy(&value, &data, sizeof(value));
+    return true;
+}
+
+void TranspositionTable::store(uint64_t key, double value) {
+    uint64_t data;
+    memcpy(&data, &value, sizeof(data));
+    Slot &slot = slots[key & mask];
+    slot.check.store(key ^ data, std::memory_order_relaxed);
+    slot.data.store(data, std::memory_order_relaxed);
+}
+
+void TranspositionTable::clear() {
+    // a zeroed slot only matches key 0, which no board and piece hash to
+    for (uint64_t i = 0; i <= mask; ++i) {
+        slots[i].check.store(0, std::memory_order_relaxed);
+        slots[i].data.store(0, std::memory_order_relaxed);
+    }
+}
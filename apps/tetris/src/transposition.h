@@ -0,0 +1,45 @@
+#ifndef TRANSPOSITION_H
+#define TRANSPOSITION_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include "bitboard.h"
+
+// Lock-free cache of search results keyed by a Zobrist hash of the board.
+// Each slot stores (key ^ data, data) in two relaxed atomics; a probe only
+// hits if the pair still decodes to its key, so a slot torn by concurrent
+// stores reads as a miss instead of a wrong value (Hyatt's lockless hashing).
+// Stores always replace. Only share a table between searches that score
+// boards the same way.
+class TranspositionTable
+{
+public:
+    // 2^bits slots of 16 bytes
+    explicit TranspositionTable(int bits = 18);
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    // Zobrist hash of the board's cells
+    uint64_t key(const Bitboard&) const;
+    // mixed into a board key to tell apart results for different pieces
+    uint64_t pieceKey(int type, int rotation) const { return pieces[type][rotation]; }
+
+    bool probe(uint64_t, double&) const;
+    void store(uint64_t, double);
+    void clear();
+
+private:
+    struct Slot
+    {
+        std::atomic<uint64_t> check;
+        std::atomic<uint64_t> data;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    uint64_t mask;
+    uint64_t cells[BOARD_HEIGHT][BOARD_WIDTH];
+    uint64_t pieces[7][4];
+};
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+// Minimal assertions for the make check programs: a failed CHECK prints
+// where and what, and the program's exit status is the number of failures.
+#include <cstdio>
+
+inline int checkFailures = 0;
+
+#define CHECK(condition)                                                        \
+    do {                                                                        \
+        if (!(condition)) {                                                     \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__,   \
+                    #condition);                                                \
+            ++checkFailures;                                                    \
+        }                                                                       \
+    } while (0)
+
+// exit status of a check program
+inline int checkResult(const char *name) {
+    if (checkFailures == 0) {
+        printf("%s: ok\n", name);
+    } else {
+        printf("%s: %d failed\n", name, checkFailures);
+    }
+    return checkFailures == 0 ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,290 @@
+// replay-check: records an AI game, then checks that seeking through the
+// keyframe index lands on exactly the state decoding from the start
+// reaches, also when keyframes are corrupted or the file is truncated.
+//
+// usage: replay-check DIR, scratch files go to DIR
+#include <climits>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "../src/ai.h"
+#include "../src/replay.h"
+#include "check.h"
+
+static const unsigned int SEED = 7;
+static const int PIECES = 650;
+
+static void act(Game &game, ReplayWriter &recorder, Action action) {
+    recorder.action(action);
+    game.step(action);
+    recorder.keyframe(game);
+}
+
+static void tick(Game &game, ReplayWriter &recorder) {
+    game.tick();
+    recorder.tick();
+    recorder.keyframe(game);
+}
+
+// the AI picks the placements; every piece gets a gravity step between its
+// moves, and every third one falls on gravity alone instead of hard dropping
+static void record(const char *path) {
+    ReplayWriter recorder;
+    CHECK(recorder.open(path, SEED, RandomizerKind::Bag));
+    Game game(SEED, RandomizerKind::Bag);
+    Ai ai;
+    while (!game.isOver() && game.getPieces() < PIECES) {
+        int placed = game.getPieces();
+        Placement target = ai.search(game);
+        if (target.valid) {
+            for (int i = 0; i < target.rotations; ++i) act(game, recorder, Action::Rotate);
+            tick(game, recorder);
+            while (game.getPieces() == placed && game.current().left() < target.left) {
+                act(game, recorder, Action::Right);
+            }
+            while (game.getPieces() == placed && game.current().left() > target.left) {
+                act(game, recorder, Action::Left);
+            }
+        }
+        if (placed % 3 == 0) {
+            while (!game.isOver() && game.getPieces() == placed) tick(game, recorder);
+        } else if (game.getPieces() == placed) {
+            act(game, recorder, Action::HardDrop);
+        }
+    }
+    CHECK(recorder.close());
+}
+
+static bool sameState(const Game &a, const Game &b) {
+    if (memcmp(a.field().rows, b.field().rows, sizeof(a.field().rows)) != 0) return false;
+    if (memcmp(a.field().heights, b.field().heights, sizeof(a.field().heights)) != 0) return false;
+    for (int i = 0; i < BOARD_HEIGHT; ++i) {
+        for (int j = 0; j < BOARD_WIDTH; ++j) {
+            if (a.cellColor(i, j) != b.cellColor(i, j)) return false;
+        }
+    }
+    for (int i = 0; i < PREVIEW_SIZE; ++i) {
+        if (a.upcoming(i).getType() != b.upcoming(i).getType() ||
+            a.upcoming(i).getRotation() != b.upcoming(i).getRotation()) {
+            return false;
+        }
+    }
+    const Tetromino &p = a.current(), &q = b.current();
+    return a.getScore() == b.getScore() && a.getLines() == b.getLines() &&
+           a.getPieces() == b.getPieces() && a.level == b.level && a.isOver() == b.isOver() &&
+           p.getType() == q.getType() && p.getRotation() == q.getRotation() &&
+           p.left() == q.left() && p.top() == q.top();
+}
+
+// decode from the start with next() alone until `piece` spawned or `ticks`
+// gravity steps ran, independently of ReplayReader::seek
+static bool decodeTo(const char *path, int piece, uint32_t ticks, Game &game) {
+    ReplayReader reader;
+    if (!reader.open(path)) return false;
+    uint32_t ran = 0;
+    ReplayEvent event;
+    while (game.getPieces() < piece && ran < ticks) {
+        if (!reader.next(event)) return false;
+        for (uint32_t i = 0; i < event.ticks && game.getPieces() < piece && ran < ticks; ++i) {
+            game.tick();
+            ++ran;
+        }
+        if (game.getPieces() >= piece || ran >= ticks) break;
+        if (event.end) return false;
+        game.step(event.action);
+    }
+    return true;
+}
+
+// the rest of the recording after a seek
+static void finish(ReplayReader &reader, Game &game) {
+    ReplayEvent event;
+    while (reader.next(event)) {
+        for (uint32_t i = 0; i < event.ticks; ++i) game.tick();
+        if (event.end) break;
+        game.step(event.action);
+    }
+}
+
+static std::vector<uint8_t> load(const char *path) {
+    std::vector<uint8_t> bytes;
+    FILE *in = fopen(path, "rb");
+    if (in == NULL) return bytes;
+    int c;
+    while ((c = fgetc(in)) != EOF) bytes.push_back(static_cast<uint8_t>(c));
+    fclose(in);
+    return bytes;
+}
+
+static void store(const char *path, const std::vector<uint8_t> &bytes) {
+    FILE *out = fopen(path, "wb");
+    CHECK(out != NULL);
+    if (out == NULL) return;
+    fwrite(bytes.data(), 1, bytes.size(), out);
+    fclose(out);
+}
+
+static uint32_t fnv1a(const uint8_t *p, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i) hash = (hash ^ p[i]) * 16777619u;
+    return hash;
+}
+
+static uint32_t getU32(const std::vector<uint8_t> &bytes, size_t at) {
+    return bytes[at] | bytes[at + 1] << 8 | bytes[at + 2] << 16 |
+           static_cast<uint32_t>(bytes[at + 3]) << 24;
+}
+
+static void putU32(std::vector<uint8_t> &bytes, size_t at, uint32_t value) {
+    for (int i = 0; i < 4; ++i) bytes[at + i] = (value >> (8 * i)) & 0xff;
+}
+
+// Every seek into `path` must match decoding `original` from the start,
+// and continuing from there must reach the same final state. A seek may
+// fail only if `mayFail` (a truncated file), never land somewhere else.
+static int checkSeeks(const char *path, const char *original, bool mayFail) {
+    int seeks = 0;
+    // the final state: decodeTo() only stops at the end of the recording
+    Game full(SEED, RandomizerKind::Bag);
+    decodeTo(original, INT_MAX, UINT_MAX, full);
+    for (int piece = 1; piece < PIECES; piece += 23) {
+        ReplayReader reader;
+        if (!reader.open(path)) {
+            CHECK(mayFail);
+            return seeks;
+        }
+        Game sought(SEED, RandomizerKind::Bag), decoded(SEED, RandomizerKind::Bag);
+        bool found = reader.seek(piece, sought);
+        bool reachable = decodeTo(original, piece, UINT_MAX, decoded);
+        CHECK(found || mayFail || !reachable);
+        if (!found) continue;
+        CHECK(sameState(sought, decoded));
+        if (!mayFail) {
+            finish(reader, sought);
+            CHECK(sameState(sought, full));
+        }
+        ++seeks;
+    }
+    // up to the first gravity step past the end of the recording
+    for (uint32_t ticks = 0;; ticks += 397) {
+        ReplayReader reader;
+        if (!reader.open(path)) return seeks;
+        Game sought(SEED, RandomizerKind::Bag), decoded(SEED, RandomizerKind::Bag);
+        bool found = reader.seekTicks(ticks, sought);
+        bool reachable = decodeTo(original, INT_MAX, ticks, decoded);
+        CHECK(found == reachable || (mayFail && !found));
+        if (!reachable) break;
+        if (!found) continue;
+        CHECK(sameState(sought, decoded));
+        if (!mayFail) {
+            finish(reader, sought);
+            CHECK(sameState(sought, full));
+        }
+        ++seeks;
+    }
+    return seeks;
+}
+
+int main(int argc, char **argv) {
+    std::string dir = argc > 1 ? argv[1] : ".";
+    std::string path = dir + "/replay-check.ttr";
+    std::string damaged = dir + "/replay-check-damaged.ttr";
+    record(path.c_str());
+
+    ReplayReader reader;
+    CHECK(reader.open(path.c_str()));
+    size_t keyframes = reader.keyframeCount();
+    CHECK(keyframes >= 5);
+    reader.close();
+    CHECK(checkSeeks(path.c_str(), path.c_str(), false) > 0);
+
+    std::vector<uint8_t> bytes = load(path.c_str());
+    size_t trailer = bytes.size() - 16;
+    size_t indexAt = getU32(bytes, trailer + 8);
+    size_t entrySize = 5 * 4;
+    size_t snapshotsAt = indexAt - keyframes * sizeof(Snapshot);
+
+    // the keyframes are what seeks start from: with every event before the
+    // last one scrambled, a seek past it still lands right
+    {
+        size_t last = indexAt + (keyframes - 1) * entrySize;
+        std::vector<uint8_t> copy = bytes;
+        for (size_t i = 10; i < getU32(bytes, last); ++i) copy[i] = static_cast<uint8_t>(i * 7);
+        store(damaged.c_str(), copy);
+        int piece = static_cast<int>(getU32(bytes, last + 8)) + 17;
+        ReplayReader scrambled;
+        CHECK(scrambled.open(damaged.c_str()));
+        Game sought(SEED, RandomizerKind::Bag), decoded(SEED, RandomizerKind::Bag);
+        CHECK(scrambled.seek(piece, sought));
+        CHECK(decodeTo(path.c_str(), piece, UINT_MAX, decoded));
+        CHECK(sameState(sought, decoded));
+    }
+
+    // a flipped bit anywhere in a snapshot fails its checksum
+    for (size_t k = 0; k < keyframes; k += 2) {
+        std::vector<uint8_t> copy = bytes;
+        copy[snapshotsAt + k * sizeof(Snapshot) + (k * 131) % sizeof(Snapshot)] ^= 0x10;
+        store(damaged.c_str(), copy);
+        CHECK(checkSeeks(damaged.c_str(), path.c_str(), false) > 0);
+    }
+
+    // fields out of range behind a matching checksum: a bool that isn't
+    // one, a piece type past shapeTable, a board with a bit outside the walls
+    size_t fields[] = {offsetof(Snapshot, over), offsetof(Snapshot, tetromino),
+                       offsetof(Snapshot, board)};
+    for (size_t f = 0; f < sizeof(fields) / sizeof(fields[0]); ++f) {
+        std::vector<uint8_t> copy = bytes;
+        for (size_t k = 0; k < keyframes; ++k) {
+            size_t at = snapshotsAt + k * sizeof(Snapshot);
+            memset(&copy[at + fields[f]], 0x7f, f == 0 ? 1 : 4);
+            putU32(copy, indexAt + k * entrySize + 16, fnv1a(&copy[at], sizeof(Snapshot)));
+        }
+        store(damaged.c_str(), copy);
+        CHECK(checkSeeks(damaged.c_str(), path.c_str(), false) > 0);
+    }
+
+    // a keyframe pointing past the events
+    {
+        std::vector<uint8_t> copy = bytes;
+        for (size_t k = 0; k < keyframes; ++k) putU32(copy, indexAt + k * entrySize, 0xfffffff0u);
+        store(damaged.c_str(), copy);
+        CHECK(checkSeeks(damaged.c_str(), path.c_str(), false) > 0);
+    }
+
+    // an action code past HardDrop ends the stream where it is, as a
+    // corrupt one, instead of reaching Game::step
+    {
+        std::vector<uint8_t> copy = bytes;
+        size_t at = 10, code = 0;
+        for (int event = 0; event < 100; ++event) {
+            while (copy[at] & 0x80) ++at;
+            code = at + 1;
+            at += 2;
+        }
+        copy[code] = static_cast<uint8_t>(Action::HardDrop) + 1;
+        store(damaged.c_str(), copy);
+        ReplayReader corrupt;
+        CHECK(corrupt.open(damaged.c_str()));
+        ReplayEvent event;
+        int events = 0;
+        while (corrupt.next(event)) {
+            CHECK(event.end || event.action <= Action::HardDrop);
+            ++events;
+        }
+        CHECK(events == 99);
+        checkSeeks(damaged.c_str(), path.c_str(), true);
+    }
+
+    // truncated anywhere: no crash, and no seek that lands elsewhere
+    for (size_t length = 0; length < bytes.size(); length += bytes.size() / 29 + 1) {
+        std::vector<uint8_t> copy(bytes.begin(), bytes.begin() + length);
+        store(damaged.c_str(), copy);
+        checkSeeks(damaged.c_str(), path.c_str(), true);
+    }
+
+    remove(path.c_str());
+    remove(damaged.c_str());
+    return checkResult("replay-check");
+}
@@ -0,0 +1,65 @@
+// rowkernels-check: the AI's feature kernel boardFeatures() matches
+// counting the cells one by one, on random boards of every height and in
+// batches of every size the AI passes.
+//
+// usage: rowkernels-check
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "../src/rowkernels.h"
+#include "check.h"
+
+static const int BOARDS = 20000;
+
+// columns filled up to a random height with random holes under it, plus
+// some boards that are empty, full or a single column
+static Bitboard randomBoard(std::mt19937 &gen, int b) {
+    Bitboard board;
+    board.clear();
+    int shape = b % 8;
+    for (int j = 0; j < BOARD_WIDTH; ++j) {
+        int top = shape == 0 ? 0 : shape == 1 ? BOARD_HEIGHT :
+                  shape == 2 ? (j == b % BOARD_WIDTH ? BOARD_HEIGHT : 0) :
+                  static_cast<int>(gen() % (BOARD_HEIGHT + 1));
+        for (int i = BOARD_HEIGHT - top; i < BOARD_HEIGHT; ++i) {
+            // the top cell of a column is always set, below it 1 in 4 is a hole
+            if (i == BOARD_HEIGHT - top || shape == 1 || gen() % 4 != 0) {
+                board.rows[i] |= 1 << j;
+            }
+        }
+    }
+    board.updateHeights();
+    return board;
+}
+
+static BoardFeatures reference(const Bitboard &board) {
+    BoardFeatures f = {0, 0, 0};
+    for (int j = 0; j < BOARD_WIDTH; ++j) {
+        f.height += board.heights[j];
+        if (j > 0) f.bumpiness += std::abs(board.heights[j] - board.heights[j - 1]);
+        for (int i = 0; i < BOARD_HEIGHT; ++i) f.cells += (board.rows[i] >> j) & 1;
+    }
+    return f;
+}
+
+static bool same(const BoardFeatures &a, const BoardFeatures &b) {
+    return a.height == b.height && a.cells == b.cells && a.bumpiness == b.bumpiness;
+}
+
+int main() {
+    std::mt19937 gen(1);
+    std::vector<Bitboard> boards;
+    for (int b = 0; b < BOARDS; ++b) boards.push_back(randomBoard(gen, b));
+
+    // whole batches and odd tails, as the AI passes them
+    size_t counts[] = {1, 3, 17, 100, boards.size()};
+    for (size_t count : counts) {
+        for (size_t first = 0; first + count <= boards.size(); first += count * 7 + 1) {
+            std::vector<BoardFeatures> features(count);
+            boardFeatures(&boards[first], count, features.data());
+            for (size_t b = 0; b < count; ++b) CHECK(same(features[b], reference(boards[first + b])));
+        }
+    }
+    return checkResult("rowkernels-check");
+}
@@ -0,0 +1,138 @@
+// scores-check: crash and concurrency checks of the score store.
+//
+//   - a writer killed with SIGKILL at random moments never leaves a store
+//     that fails to open or loses a game record() had returned for
+//   - a torn header slot falls back to the other one
+//   - games recording into one store at once, across a compaction, keep
+//     every game in the totals
+//
+// usage: scores-check DIR, scratch files go to DIR
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../src/scores.h"
+#include "check.h"
+
+static const size_t HEADER_SLOT = 512;
+
+// the games of one writer are numbered, score = number + 1 and lines =
+// number, so the totals say which games made it
+static bool recordGames(ScoreStore &store, uint32_t first, uint32_t count, int acknowledge) {
+    for (uint32_t i = first; i < first + count; ++i) {
+        if (store.record(i + 1, i, 1, 0) < 0) return false;
+        if (acknowledge >= 0 && write(acknowledge, &i, sizeof(i)) != sizeof(i)) return false;
+    }
+    return true;
+}
+
+static void checkKilledWriter(const std::string &path) {
+    unlink(path.c_str());
+    srand(12345);
+    uint32_t acknowledged = 0;
+    for (int round = 0; round < 40; ++round) {
+        int pipeFds[2];
+        CHECK(pipe(pipeFds) == 0);
+        pid_t child = fork();
+        if (child == 0) {
+            close(pipeFds[0]);
+            ScoreStore store;
+            if (!store.open(path.c_str())) _exit(2);
+            recordGames(store, static_cast<uint32_t>(store.totals().sessions), 100000, pipeFds[1]);
+            _exit(0);
+        }
+        close(pipeFds[1]);
+        // a few milliseconds of appends, then the power cut
+        usleep(1000 + rand() % 20000);
+        kill(child, SIGKILL);
+        int status;
+        waitpid(child, &status, 0);
+        uint32_t game;
+        while (read(pipeFds[0], &game, sizeof(game)) == sizeof(game)) acknowledged = game + 1;
+        close(pipeFds[0]);
+
+        // every acknowledged game is there, at most the one in flight more
+        ScoreStore store;
+        CHECK(store.open(path.c_str()));
+        uint64_t sessions = store.totals().sessions;
+        CHECK(sessions >= acknowledged && sessions <= acknowledged + 1);
+        uint64_t lines = sessions * (sessions - 1) / 2;
+        CHECK(store.totals().lines == lines);
+        acknowledged = static_cast<uint32_t>(sessions);
+    }
+    // the log holds 1024 records, so the rounds went through compactions
+    CHECK(acknowledged > SCORE_LOG_CAPACITY);
+}
+
+static void checkTornHeader(const std::string &path) {
+    unlink(path.c_str());
+    {
+        ScoreStore store;
+        CHECK(store.open(path.c_str()));
+        CHECK(recordGames(store, 0, 5, -1));
+    }
+    for (int slot = 0; slot < 2; ++slot) {
+        std::string copy = path + ".torn";
+        char command[1024];
+        snprintf(command, sizeof(command), "cp '%s' '%s'", path.c_str(), copy.c_str());
+        CHECK(system(command) == 0);
+        int fd = open(copy.c_str(), O_WRONLY);
+        CHECK(fd >= 0);
+        char garbage[64];
+        memset(garbage, 0xa5, sizeof(garbage));
+        CHECK(pwrite(fd, garbage, sizeof(garbage), slot * HEADER_SLOT + 100) == sizeof(garbage));
+        close(fd);
+        // the older header plus the roll forward of the newest record
+        ScoreStore store;
+        CHECK(store.open(copy.c_str()));
+        CHECK(store.totals().sessions == 5);
+        CHECK(store.tableSize() == 5 && store.table(0).score == 5);
+        unlink(copy.c_str());
+    }
+}
+
+static void checkConcurrentGames(const std::string &path) {
+    unlink(path.c_str());
+    const int writers = 4;
+    const uint32_t games = 300;
+    pid_t children[writers];
+    for (int w = 0; w < writers; ++w) {
+        children[w] = fork();
+        if (children[w] == 0) {
+            // opened before any of them records, like games started together
+            ScoreStore store;
+            if (!store.open(path.c_str())) _exit(2);
+            usleep(20000);
+            _exit(recordGames(store, w * games, games, -1) ? 0 : 1);
+        }
+    }
+    for (int w = 0; w < writers; ++w) {
+        int status;
+        waitpid(children[w], &status, 0);
+        CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+    ScoreStore store;
+    CHECK(store.open(path.c_str()));
+    uint64_t total = static_cast<uint64_t>(writers) * games;
+    CHECK(store.totals().sessions == total);
+    CHECK(store.totals().lines == total * (total - 1) / 2);
+    CHECK(store.tableSize() == SCORE_TABLE_SIZE && store.table(0).score == total);
+    // more games than the log holds, so someone compacted
+    CHECK(store.logSize() < total);
+}
+
+int main(int argc, char **argv) {
+    std::string dir = argc > 1 ? argv[1] : ".";
+    std::string path = dir + "/scores-check.store";
+    checkKilledWriter(path);
+    checkTornHeader(path);
+    checkConcurrentGames(path);
+    unlink(path.c_str());
+    unlink((path + ".tmp").c_str());
+    return checkResult("scores-check");
+}